@@ -15,9 +15,17 @@
 typedef struct ac_image ac_image;
 typedef struct ac_processor ac_processor;
 
+// a source of image buffers, see ac::core::Allocator.
+typedef struct ac_allocator {
+    void* (*allocate)(size_t size, void* userdata);
+    void (*deallocate)(void* ptr, size_t size, void* userdata);
+    void* userdata;
+} ac_allocator;
+
 enum ac_image_element_type {
     AC_IMAGE_UINT8   = 0 << 8 | 1,
     AC_IMAGE_UINT16  = 0 << 8 | 2,
+    AC_IMAGE_FLOAT16 = 2 << 8 | 2,
     AC_IMAGE_FLOAT32 = 2 << 8 | 4
 };
 
@@ -27,6 +35,18 @@ enum ac_processor_type {
     AC_PROCESSOR_CUDA   = 2
 };
 
+enum ac_execution_policy {
+    AC_EXECUTION_AUTO     = 0,
+    AC_EXECUTION_SERIAL   = 1,
+    AC_EXECUTION_PARALLEL = 2
+};
+
+enum ac_allocator_type {
+    AC_ALLOCATOR_SYSTEM    = 0,
+    AC_ALLOCATOR_POOL      = 1,
+    AC_ALLOCATOR_HUGE_PAGE = 2
+};
+
 enum ac_model_type {
     AC_MODEL_ACNET_HDN0,
     AC_MODEL_ACNET_HDN1,
@@ -65,14 +85,34 @@ CAC_API int ac_image_is_uint(const ac_image* image);
 CAC_API int ac_image_is_int(const ac_image* image);
 CAC_API int ac_image_is_float(const ac_image* image);
 CAC_API int ac_image_same(const ac_image* a, const ac_image* b);
+// a new image viewing the sub-rectangle of `image`, sharing its buffer, see ac::core::Image::roi.
+CAC_API ac_image* ac_image_roi(const ac_image* image, int x, int y, int w, int h);
 
 CAC_API ac_processor* ac_processor_create(int processor_type, int device, int model_type);
 CAC_API void ac_processor_destroy(ac_processor* processor);
 CAC_API void ac_processor_process(ac_processor* processor, const ac_image* src, ac_image* dst, double factor);
+// process an image band by band within about `budget` bytes, see ac::core::Processor::processBands.
+// `read` and `write` return 0 to stop, `band` is only valid during the call. returns 0 on failure.
+CAC_API int ac_processor_process_bands(ac_processor* processor, int w, int h, int c, int element_type,
+    int (*read)(int y, ac_image* band, void* userdata), int (*write)(int y, const ac_image* band, void* userdata), void* userdata, double factor, size_t budget);
 CAC_API int ac_processor_ok(const ac_processor* processor);
 CAC_API const char* ac_processor_error(const ac_processor* processor);
 CAC_API const char* ac_processor_name(const ac_processor* processor);
 CAC_API const char* ac_processor_info(int processor_type);
+CAC_API void ac_processor_set_execution_policy(ac_processor* processor, int policy);
+CAC_API int ac_processor_execution_policy(const ac_processor* processor);
+
+// the compute runtime starts with the first processing, the setters return 0 after that.
+CAC_API int ac_runtime_set_threads(int threads);
+CAC_API int ac_runtime_set_affinity(int enable);
+CAC_API int ac_runtime_threads(void);
+CAC_API int ac_runtime_affinity(void);
+
+// a built-in allocator, the system allocator for an unknown type.
+CAC_API ac_allocator ac_allocator_builtin(int allocator_type);
+// new image buffers come from `allocator`, or the system allocator if it is NULL.
+CAC_API void ac_allocator_set(const ac_allocator* allocator);
+CAC_API ac_allocator ac_allocator_get(void);
 
 CAC_API void ac_imread(const char* filename, int flag, ac_image* image);
 CAC_API int ac_imwrite(const char* filename, const ac_image* image);
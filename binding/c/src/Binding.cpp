@@ -101,6 +101,10 @@ int ac_image_same(const ac_image* const a, const ac_image* const b)
 {
     return a->object == b->object;
 }
+ac_image* ac_image_roi(const ac_image* const image, const int x, const int y, const int w, const int h)
+{
+    return new ac_image{ image->object.roi(x, y, w, h) };
+}
 
 ac_processor* ac_processor_create(const int processor_type, const int device, const int model_type)
 {
@@ -143,6 +147,19 @@ void ac_processor_process(ac_processor* const processor, const ac_image* const s
 {
     processor->object->process(src->object, dst->object, factor);
 }
+int ac_processor_process_bands(ac_processor* const processor, const int w, const int h, const int c, const int element_type,
+    int (* const read)(int, ac_image*, void*), int (* const write)(int, const ac_image*, void*), void* const userdata, const double factor, const size_t budget)
+{
+    return processor->object->processBands(w, h, c, element_type,
+        [&](const int y, ac::core::Image& band) {
+            ac_image image{ band };
+            return read(y, &image, userdata) != 0;
+        },
+        [&](const int y, const ac::core::Image& band) {
+            const ac_image image{ band };
+            return write(y, &image, userdata) != 0;
+        }, factor, budget);
+}
 int ac_processor_ok(const ac_processor* const processor)
 {
     return processor->object->ok();
@@ -169,6 +186,53 @@ const char* ac_processor_info(const int processor_type)
     default: return "unsupported processor";
     }
 }
+void ac_processor_set_execution_policy(ac_processor* const processor, const int policy)
+{
+    processor->object->setExecutionPolicy(policy);
+}
+int ac_processor_execution_policy(const ac_processor* const processor)
+{
+    return processor->object->executionPolicy();
+}
+
+int ac_runtime_set_threads(const int threads)
+{
+    return ac::core::runtime::setThreads(threads);
+}
+int ac_runtime_set_affinity(const int enable)
+{
+    return ac::core::runtime::setAffinity(enable);
+}
+int ac_runtime_threads(void)
+{
+    return ac::core::runtime::threads();
+}
+int ac_runtime_affinity(void)
+{
+    return ac::core::runtime::affinity();
+}
+
+ac_allocator ac_allocator_builtin(const int allocator_type)
+{
+    ac::core::Allocator allocator{};
+    switch (allocator_type)
+    {
+    case AC_ALLOCATOR_POOL: allocator = ac::core::allocator::pool(); break;
+    case AC_ALLOCATOR_HUGE_PAGE: allocator = ac::core::allocator::hugePage(); break;
+    default: allocator = ac::core::allocator::system(); break;
+    }
+    return { allocator.allocate, allocator.deallocate, allocator.userdata };
+}
+void ac_allocator_set(const ac_allocator* const allocator)
+{
+    if (allocator) ac::core::allocator::set({ allocator->allocate, allocator->deallocate, allocator->userdata });
+    else ac::core::allocator::set(ac::core::allocator::system());
+}
+ac_allocator ac_allocator_get(void)
+{
+    auto allocator = ac::core::allocator::get();
+    return { allocator.allocate, allocator.deallocate, allocator.userdata };
+}
 
 #ifdef AC_CORE_ENABLE_IMAGE_IO
 void ac_imread(const char* const filename, const int flag, ac_image* const image)
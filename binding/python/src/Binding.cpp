@@ -1,3 +1,5 @@
+#include <cstddef>
+#include <cstdint>
 #include <tuple>
 
 #include <pybind11/pybind11.h>
@@ -72,6 +74,8 @@ PYBIND11_MODULE(pyac, m)
         .def("ok", &ac::core::Processor::ok)
         .def("error", &ac::core::Processor::error)
         .def("name", &ac::core::Processor::name)
+        .def("set_execution_policy", &ac::core::Processor::setExecutionPolicy)
+        .def("execution_policy", &ac::core::Processor::executionPolicy)
         .def_static("info_list", []() {
             return std::make_tuple(
                 ac::core::Processor::info<ac::core::Processor::CPU>(),
@@ -89,5 +93,41 @@ PYBIND11_MODULE(pyac, m)
         })
         .def_readonly_static("CPU", &ac::core::Processor::CPU)
         .def_readonly_static("OpenCL", &ac::core::Processor::OpenCL)
-        .def_readonly_static("CUDA", &ac::core::Processor::CUDA);
+        .def_readonly_static("CUDA", &ac::core::Processor::CUDA)
+        .def_readonly_static("ExecutionAuto", &ac::core::Processor::ExecutionAuto)
+        .def_readonly_static("ExecutionSerial", &ac::core::Processor::ExecutionSerial)
+        .def_readonly_static("ExecutionParallel", &ac::core::Processor::ExecutionParallel);
+
+    auto allocator = core.def_submodule("allocator");
+
+    allocator.attr("SYSTEM") = 0;
+    allocator.attr("POOL") = 1;
+    allocator.attr("HUGE_PAGE") = 2;
+
+    allocator.def("use", [](const int type) {
+        switch (type)
+        {
+        case 0: return ac::core::allocator::set(ac::core::allocator::system());
+        case 1: return ac::core::allocator::set(ac::core::allocator::pool());
+        case 2: return ac::core::allocator::set(ac::core::allocator::hugePage());
+        default: throw py::value_error{ "unknown allocator type" };
+        }
+    }, "make new image buffers come from a built-in allocator.", py::arg("type"));
+    allocator.def("set", [](const std::uintptr_t allocate, const std::uintptr_t deallocate, const std::uintptr_t userdata) {
+        if (!allocate || !deallocate) throw py::value_error{ "null allocator function" };
+        ac::core::allocator::set({
+            reinterpret_cast<void* (*)(std::size_t, void*)>(allocate),
+            reinterpret_cast<void (*)(void*, std::size_t, void*)>(deallocate),
+            reinterpret_cast<void*>(userdata)
+        });
+    }, "make new image buffers come from native functions, given by address such as ctypes function pointers, "
+       "void* allocate(size_t size, void* userdata) and void deallocate(void* ptr, size_t size, void* userdata), they must outlive every buffer.",
+       py::arg("allocate"), py::arg("deallocate"), py::arg("userdata") = 0);
+
+    auto runtime = core.def_submodule("runtime");
+
+    runtime.def("set_threads", &ac::core::runtime::setThreads, "set the number of compute threads, 0 for all hardware threads, returns False if the runtime has already started.", py::arg("threads"));
+    runtime.def("set_affinity", &ac::core::runtime::setAffinity, "pin compute threads to cpu cores, returns False if the runtime has already started.", py::arg("enable"));
+    runtime.def("threads", &ac::core::runtime::threads);
+    runtime.def("affinity", &ac::core::runtime::affinity);
 }
@@ -12,6 +12,9 @@ struct Options
     std::string processor{"cpu"};
     double factor = 2.0;
     int device = 0;
+    int threads = 0;
+    int budget = 0;
+    bool affinity = false;
     bool list = false;
     bool version = false;
     struct {
@@ -1,9 +1,17 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <future>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "AC/Core.hpp"
 #include "AC/Util/Stopwatch.hpp"
-#include "AC/Util/ThreadPool.hpp"
 #ifdef AC_CLI_ENABLE_VIDEO
 #   include "AC/Video.hpp"
 #endif
@@ -49,16 +57,132 @@ static void list()
 #   endif
 }
 
+// binary PGM and PPM files can be read and written row by row, so they are streamed when a memory budget is given
+static bool pnm(const std::string& filename)
+{
+    if (filename.size() < 4) return false;
+    auto ext = filename.substr(filename.size() - 4);
+    for (auto&& ch : ext) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    return ext == ".pgm" || ext == ".ppm" || ext == ".pnm";
+}
+static bool readPNMHeader(std::FILE* const file, int& w, int& h, int& c, int& maxval)
+{
+    // a decimal number after whitespace and comments, the single whitespace after it is consumed too
+    auto number = [&]() -> int {
+        int ch = std::fgetc(file);
+        while (ch == '#' || std::isspace(ch))
+        {
+            if (ch == '#') while (ch != '\n' && ch != EOF) ch = std::fgetc(file);
+            ch = std::fgetc(file);
+        }
+        if (!std::isdigit(ch)) return -1;
+        int value = 0;
+        for (; std::isdigit(ch) && value < (1 << 24); ch = std::fgetc(file)) value = value * 10 + (ch - '0');
+        return value;
+    };
+    if (std::fgetc(file) != 'P') return false;
+    switch (std::fgetc(file))
+    {
+    case '5': c = 1; break;
+    case '6': c = 3; break;
+    default: return false;
+    }
+    w = number();
+    h = number();
+    maxval = number();
+    return w > 0 && h > 0 && maxval > 0 && maxval < 65536;
+}
+// upscale a binary PGM or PPM file to another one band by band, so only about `budget` bytes of it are held in memory
+static bool stream(const std::shared_ptr<ac::core::Processor>& processor, const char* const input, const char* const output, const double factor, const std::size_t budget)
+{
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> in{ std::fopen(input, "rb"), &std::fclose };
+    int w = 0, h = 0, c = 0, maxval = 0;
+    if (!in || !readPNMHeader(in.get(), w, h, c, maxval)) return false;
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> out{ std::fopen(output, "wb"), &std::fclose };
+    if (!out) return false;
+    std::fprintf(out.get(), "P%d\n%d %d\n%d\n", c == 1 ? 5 : 6, ac::core::Processor::scaledSize(w, factor), ac::core::Processor::scaledSize(h, factor), maxval);
+
+    // the 16-bit samples are big-endian. samples of a maxval other than 255 or 65535 are scaled to the full range of their type
+    // for processing and back when written, so the result keeps the maxval of the input
+    const bool wide = maxval > 255;
+    const std::uint32_t full = wide ? 65535 : 255, limit = static_cast<std::uint32_t>(maxval);
+    const bool rescale = limit != full;
+    auto expand = [&](const std::uint32_t v) { return (std::min(v, limit) * full + limit / 2) / limit; };
+    auto reduce = [&](const std::uint32_t v) { return (v * limit + full / 2) / full; };
+    std::vector<std::uint8_t> row{};
+    return processor->processBands(w, h, c, wide ? ac::core::Image::UInt16 : ac::core::Image::UInt8,
+        [&](const int /*y*/, ac::core::Image& band) {
+            const auto count = static_cast<std::size_t>(band.width()) * c;
+            for (int i = 0; i < band.height(); i++)
+            {
+                if (std::fread(band.line(i), band.elementSize(), count, in.get()) != count) return false;
+                if (wide)
+                    for (std::size_t j = 0; j < count; j++)
+                    {
+                        auto p = band.line(i) + j * 2;
+                        auto v = static_cast<std::uint16_t>(rescale ? expand(p[0] << 8 | p[1]) : (p[0] << 8 | p[1]));
+                        std::memcpy(p, &v, sizeof(v));
+                    }
+                else if (rescale)
+                    for (std::size_t j = 0; j < count; j++) band.line(i)[j] = static_cast<std::uint8_t>(expand(band.line(i)[j]));
+            }
+            return true;
+        },
+        [&](const int /*y*/, const ac::core::Image& band) {
+            const auto count = static_cast<std::size_t>(band.width()) * c;
+            for (int i = 0; i < band.height(); i++)
+            {
+                const std::uint8_t* data = band.line(i);
+                if (wide)
+                {
+                    row.resize(count * 2);
+                    for (std::size_t j = 0; j < count; j++)
+                    {
+                        std::uint16_t v = 0;
+                        std::memcpy(&v, band.line(i) + j * 2, sizeof(v));
+                        if (rescale) v = static_cast<std::uint16_t>(reduce(v));
+                        row[j * 2] = static_cast<std::uint8_t>(v >> 8);
+                        row[j * 2 + 1] = static_cast<std::uint8_t>(v & 0xff);
+                    }
+                    data = row.data();
+                }
+                else if (rescale)
+                {
+                    row.resize(count);
+                    for (std::size_t j = 0; j < count; j++) row[j] = static_cast<std::uint8_t>(reduce(band.line(i)[j]));
+                    data = row.data();
+                }
+                if (std::fwrite(data, band.elementSize(), count, out.get()) != count) return false;
+            }
+            return true;
+        }, factor, budget) && std::fflush(out.get()) == 0;
+}
+
 static void image(const std::shared_ptr<ac::core::Processor>& processor, Options& options)
 {
     auto batch = options.inputs.size();
-    auto threads = ac::util::ThreadPool::hardwareThreads();
-    auto targetThreads = options.processor == "cpu" ? threads / 4 + 1 : threads / 2 + 1;
-    auto poolSize = batch > targetThreads ? targetThreads : batch;
-    auto task = [&](const int i) {
+    auto threads = static_cast<decltype(batch)>(ac::core::runtime::threads());
+    // with at least one image per compute thread, run one lane per thread with serial kernels instead of splitting each image
+    auto frameParallel = options.processor == "cpu" && batch >= threads;
+    auto targetThreads = frameParallel ? threads : options.processor == "cpu" ? threads / 4 + 1 : threads / 2 + 1;
+    auto lanes = batch > targetThreads ? targetThreads : batch;
+    processor->setExecutionPolicy(frameParallel ? ac::core::Processor::ExecutionSerial : ac::core::Processor::ExecutionAuto);
+    auto task = [&](const decltype(batch) i) {
         auto& input = options.inputs[i];
         auto& output = options.outputs[i];
 
+        if (options.budget > 0 && pnm(input) && (output.empty() || pnm(output)))
+        {
+            if (output.empty()) output = input + ".out" + input.substr(input.size() - 4);
+            ac::util::Stopwatch stopwatch{};
+            auto done = stream(processor, input.c_str(), output.c_str(), options.factor, static_cast<std::size_t>(options.budget) << 20);
+            stopwatch.stop();
+            CHECK_PROCESSOR(processor);
+            if (done) std::printf("%s: Finished in %lfs within %d MiB\nSave image to %s\n", input.c_str(), stopwatch.elapsed(), options.budget, output.c_str());
+            else std::printf("Failed to stream %s to %s within %d MiB\n", input.c_str(), output.c_str(), options.budget);
+            return;
+        }
+
         if (output.empty()) output = input + ".out.jpg";
 
         auto src = ac::core::imread(input.c_str(), ac::core::IMREAD_UNCHANGED);
@@ -84,12 +208,18 @@ static void image(const std::shared_ptr<ac::core::Processor>& processor, Options
             return;
         }
     };
-    if (poolSize > 1)
+    // each lane takes the next image until all are done, the calling thread runs one lane itself
+    std::atomic<decltype(batch)> next = 0;
+    auto lane = [&]() { for (auto i = next++; i < batch; i = next++) task(i); };
+    std::vector<std::future<void>> helpers{};
+    for (decltype(lanes) i = 1; i < lanes; i++)
     {
-        ac::util::ThreadPool pool{ poolSize };
-        for (decltype(batch) i = 0; i < batch; i++) pool.exec([i, &task]() { task(i); });
+        auto helper = std::make_shared<std::packaged_task<void()>>(lane);
+        helpers.emplace_back(helper->get_future());
+        ac::core::runtime::submit([helper]() { (*helper)(); });
     }
-    else for (decltype(batch) i = 0; i < batch; i++) task(i);
+    lane();
+    for (auto&& helper : helpers) helper.wait();
 }
 
 static void video([[maybe_unused]] const std::shared_ptr<ac::core::Processor>& processor, [[maybe_unused]] Options& options)
@@ -137,6 +267,8 @@ static void video([[maybe_unused]] const std::shared_ptr<ac::core::Processor>& p
         data.processor = processor;
 
         ac::util::Stopwatch stopwatch{};
+        // frames are already processed in parallel
+        processor->setExecutionPolicy(ac::core::Processor::ExecutionSerial);
         ac::video::filter(pipeline, [](ac::video::Frame& src, ac::video::Frame& dst, void* userdata) -> bool {
             auto ctx = static_cast<decltype(data)*>(userdata);
             // y
@@ -194,6 +326,9 @@ int main(int argc, char* argv[])
     if (options.inputs.empty()) return 0;
     options.outputs.resize(options.inputs.size());
 
+    ac::core::runtime::setThreads(options.threads);
+    ac::core::runtime::setAffinity(options.affinity);
+
     auto processor = [&]() {
         ac::core::model::ACNet model { [&]() {
             if(options.model.find('1') != std::string::npos)
@@ -24,6 +24,15 @@ Options parse(const int argc, const char* const* argv) noexcept
         ->capture_default_str();
     app.add_option("-f,--factor", options.factor, "factor for upscaling.")
         ->capture_default_str();
+    app.add_option("-t,--threads", options.threads, "number of compute threads, 0 for all hardware threads.")
+        ->check(CLI::NonNegativeNumber)
+        ->capture_default_str();
+
+    app.add_option("-b,--budget", options.budget, "memory budget in MiB to process binary PGM/PPM images band by band, 0 to load whole images.")
+        ->check(CLI::NonNegativeNumber)
+        ->capture_default_str();
+
+    app.add_flag("--affinity", options.affinity, "pin compute threads to cpu cores.");
 
     app.add_flag("-l,--list", options.list, "list processor info.");
     app.add_flag("-v,--version", options.version, "show version info.");
@@ -27,6 +27,27 @@ elseif(NOT CMAKE_CXX_COMPILER_ID MATCHES "MSVC")
 endif()
 check_cxx_source_compiles("#include <immintrin.h>\nint main() { __m256 a = _mm256_set1_ps(0.0f); return 0; }" AC_COMPILER_SUPPORT_AVX)
 
+if(CMAKE_CXX_COMPILER_ID MATCHES "Clang" AND CMAKE_CXX_SIMULATE_ID MATCHES "MSVC" AND CMAKE_CXX_COMPILER_FRONTEND_VARIANT MATCHES "MSVC")
+    set(CMAKE_REQUIRED_FLAGS "/arch:AVX2")
+elseif(NOT CMAKE_CXX_COMPILER_ID MATCHES "MSVC")
+    set(CMAKE_REQUIRED_FLAGS "-mavx -mf16c")
+endif()
+check_cxx_source_compiles("#include <immintrin.h>\nint main() { __m256 a = _mm256_cvtph_ps(_mm_setzero_si128()); __m128i b = _mm256_cvtps_ph(a, _MM_FROUND_TO_NEAREST_INT); return 0; }" AC_COMPILER_SUPPORT_F16C)
+
+if(CMAKE_CXX_COMPILER_ID MATCHES "Clang" AND CMAKE_CXX_SIMULATE_ID MATCHES "MSVC" AND CMAKE_CXX_COMPILER_FRONTEND_VARIANT MATCHES "MSVC")
+    set(CMAKE_REQUIRED_FLAGS "/arch:AVX2")
+elseif(NOT CMAKE_CXX_COMPILER_ID MATCHES "MSVC")
+    set(CMAKE_REQUIRED_FLAGS "-mavx2")
+endif()
+check_cxx_source_compiles("#include <immintrin.h>\nint main() { __m256i a = _mm256_setzero_si256(); a = _mm256_madd_epi16(a, _mm256_cvtepu8_epi16(_mm_setzero_si128())); return 0; }" AC_COMPILER_SUPPORT_AVX2)
+
+if(CMAKE_CXX_COMPILER_ID MATCHES "Clang" AND CMAKE_CXX_SIMULATE_ID MATCHES "MSVC" AND CMAKE_CXX_COMPILER_FRONTEND_VARIANT MATCHES "MSVC")
+    set(CMAKE_REQUIRED_FLAGS "/arch:AVX512")
+elseif(NOT CMAKE_CXX_COMPILER_ID MATCHES "MSVC")
+    set(CMAKE_REQUIRED_FLAGS "-mavx512f")
+endif()
+check_cxx_source_compiles("#include <immintrin.h>\nint main() { __m512 s0, s1, s2; s0 = _mm512_maskz_loadu_ps(0x00ff, &s1); s0 = _mm512_fmadd_ps(s1, s2, s0); return 0; }" AC_COMPILER_SUPPORT_AVX512)
+
 if(CMAKE_CXX_COMPILER_ID MATCHES "Clang" AND CMAKE_CXX_SIMULATE_ID MATCHES "MSVC" AND CMAKE_CXX_COMPILER_FRONTEND_VARIANT MATCHES "MSVC")
     set(CMAKE_REQUIRED_FLAGS "/arch:armv8.0")
 elseif(NOT CMAKE_CXX_COMPILER_ID MATCHES "MSVC")
@@ -1,8 +1,10 @@
 #ifndef AC_CORE_HPP
 #define AC_CORE_HPP
 
+#include "AC/Core/Allocator.hpp"
 #include "AC/Core/Image.hpp"
 #include "AC/Core/Processor.hpp"
+#include "AC/Core/Runtime.hpp"
 #include "AC/Core/Model/ACNet.hpp"
 
 #endif
@@ -0,0 +1,36 @@
+#ifndef AC_CORE_ALLOCATOR_HPP
+#define AC_CORE_ALLOCATOR_HPP
+
+#include <cstddef>
+
+#include "ACExport.hpp" // Generated by CMake
+
+namespace ac::core
+{
+    struct Allocator;
+}
+
+// a source of image buffers. `allocate` returns memory aligned as malloc does, or nullptr if it fails, `deallocate` gets the same size back.
+// both are called with `userdata` and may be called from several threads at the same time.
+struct ac::core::Allocator
+{
+    void* (*allocate)(std::size_t size, void* userdata);
+    void (*deallocate)(void* ptr, std::size_t size, void* userdata);
+    void* userdata;
+};
+
+// the process-wide allocator of image buffers, and the built-in ones.
+namespace ac::core::allocator
+{
+    // malloc and free, the default.
+    AC_EXPORT Allocator system() noexcept;
+    // keeps freed buffers in size classes, four per power of two, and hands them out again, the memory is never returned to the system.
+    AC_EXPORT Allocator pool() noexcept;
+    // maps buffers of 4 MiB or more on their own and asks for transparent huge pages, only on Linux, anything else comes from `system`.
+    AC_EXPORT Allocator hugePage() noexcept;
+    // set the allocator new buffers come from, a buffer is always freed to the allocator it came from.
+    AC_EXPORT void set(const Allocator& allocator) noexcept;
+    AC_EXPORT Allocator get() noexcept;
+}
+
+#endif
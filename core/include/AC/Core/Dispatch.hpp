@@ -1,14 +1,19 @@
 #ifndef AC_CORE_LIB_DISPATCH_HPP
 #define AC_CORE_LIB_DISPATCH_HPP
 
+#include "ACExport.hpp" // Generated by CMake
+
 namespace ac::core::cpu::dispatch
 {
     // x86
-    bool supportSSE() noexcept;
-    bool supportAVX() noexcept;
-    bool supportFMA() noexcept;
+    AC_EXPORT bool supportSSE() noexcept;
+    AC_EXPORT bool supportAVX() noexcept;
+    AC_EXPORT bool supportFMA() noexcept;
+    AC_EXPORT bool supportF16C() noexcept;
+    AC_EXPORT bool supportAVX2() noexcept;
+    AC_EXPORT bool supportAVX512F() noexcept;
     // arm
-    bool supportNEON() noexcept;
+    AC_EXPORT bool supportNEON() noexcept;
 }
 
 #endif
@@ -1,6 +1,7 @@
 #ifndef AC_CORE_IMAGE_HPP
 #define AC_CORE_IMAGE_HPP
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 
@@ -101,6 +102,12 @@ namespace ac::core
 #endif
 }
 
+namespace ac::core::detail
+{
+    // number of buffers the core has allocated so far, for images and the work memory of resize, a hook for tests.
+    AC_EXPORT std::size_t allocations() noexcept;
+}
+
 class ac::core::Image
 {
 private:
@@ -111,6 +118,8 @@ public:
     using ElementType = int;
     static constexpr ElementType UInt8   = 0 << 8 | 1;
     static constexpr ElementType UInt16  = 0 << 8 | 2;
+    // IEEE 754 half precision, only a storage type, the image processing functions and processors do not take it
+    static constexpr ElementType Float16 = 2 << 8 | 2;
     static constexpr ElementType Float32 = 2 << 8 | 4;
 
 public:
@@ -124,6 +133,14 @@ public:
     AC_EXPORT Image& operator=(Image&&) noexcept;
 
     AC_EXPORT void create(int w, int h, int c, ElementType elementType, int stride = 0);
+    // a view of the `w` x `h` sub-rectangle at (`x`, `y`), it shares the buffer and stride of this image, no pixel is copied.
+    // the buffer is kept alive as long as any image shares it, the rectangle is clipped to the image, an empty image is returned if nothing is left.
+    // the image processing functions and processors read and write a view like any other image, an empty view is not a valid `dst` for them.
+    AC_EXPORT Image roi(int x, int y, int w, int h) const noexcept;
+
+    // a stride for rows of `w` pixels padded to a multiple of `alignment` bytes, a power of 2, 0 or 1 for no padding.
+    // buffers allocated by Image start on 64 bytes, so every row of them starts on `alignment` bytes up to 64.
+    AC_EXPORT static int alignedStride(int w, int c, ElementType elementType, int alignment = 64) noexcept;
 
 public:
     int width() const noexcept { return w; }
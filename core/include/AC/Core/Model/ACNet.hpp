@@ -26,11 +26,14 @@ public:
 
     const float* kernels() const noexcept { return kptr; }
     const float* biases() const noexcept { return bptr; }
+    // calibrated upper bounds of the outputs of the conv3x3 layers, used by int8 inference, see tools/calibrate
+    const float* ranges() const noexcept { return rptr; }
 
 public:
     // length in numbers
     static constexpr int kernelLength() noexcept { return 8 * 9 + 8 * 8 * 9 * 8 + 8 * 4; }
     static constexpr int biasLength() noexcept { return 8 * 9; }
+    static constexpr int rangeLength() noexcept { return 9; }
     static constexpr int kernelLength(const int idx) { return (idx == 0) ? 8 * 9 : ((idx > 0 && idx < 9) ? 8 * 8 * 9 : ((idx == 9) ? 8 * 4 : 0)); }
     static constexpr int biasLength(const int idx) { return (idx >= 0 && idx < 9) ? 8 : 0; }
     // size in bytes
@@ -67,6 +70,7 @@ public:
 private:
     const float* kptr;
     const float* bptr;
+    const float* rptr;
 };
 
 #endif
@@ -0,0 +1,18 @@
+// generated by ac_calibrate, the 99.99th percentile of the outputs of each conv3x3 layer of the float model times 1.25,
+// over 25 frames: images/Logo.png, synthetic:24
+alignas(32) constexpr float ACNet_HDN0_Int8_Ranges[] = {
++1.8295385f, +3.0450830f, +3.6820369f, +3.2924795f, +2.9184685f, +2.8021288f, +4.4697404f, +4.1424103f,
++4.4892044f,
+};
+alignas(32) constexpr float ACNet_HDN1_Int8_Ranges[] = {
++1.6757584f, +4.1079612f, +5.2875848f, +6.2336769f, +4.7458744f, +3.5077956f, +2.6672814f, +2.0019536f,
++2.8563192f,
+};
+alignas(32) constexpr float ACNet_HDN2_Int8_Ranges[] = {
++1.3790269f, +1.7229056f, +2.5894074f, +3.5942886f, +5.8424892f, +5.3454309f, +6.0942001f, +4.0430446f,
++3.7711520f,
+};
+alignas(32) constexpr float ACNet_HDN3_Int8_Ranges[] = {
++1.9817621f, +3.2023292f, +4.2469907f, +4.7402673f, +4.0267515f, +4.1330166f, +3.8164420f, +4.2343698f,
++4.4284244f,
+};
@@ -1,40 +1,187 @@
 #ifndef AC_CORE_PARALLEL_HPP
 #define AC_CORE_PARALLEL_HPP
 
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+
+#include "AC/Core/Runtime.hpp"
+
 #if defined(AC_CORE_PARALLEL_PPL)
 #   include <ppl.h>
 #elif defined(AC_CORE_PARALLEL_OPENMP)
 #   include <omp.h>
 #else
-#   include "AC/Util/ThreadPool.hpp"
+#   include <atomic>
+#   include <condition_variable>
+#   include <exception>
+#   include <memory>
+#   include <mutex>
 #endif
 
 namespace ac::core
 {
+    // a parallelFor called inside the body of another parallelFor, or under a serial ac::core::Processor, runs serially on the calling thread.
     template <typename IndexType, typename F>
     void parallelFor(IndexType first, IndexType last, F&& func);
+    // same as above, but the range is scheduled in chunks of `grain` consecutive indices.
+    template <typename IndexType, typename F>
+    void parallelFor(IndexType first, IndexType last, IndexType grain, F&& func);
+    // call `func(x, y, w, h)` in parallel for each tile of a `width` x `height` area split into `tileWidth` x `tileHeight` tiles,
+    // the tiles on the right and bottom edges may be smaller.
+    template <typename IndexType, typename F>
+    void parallelForTiles(IndexType width, IndexType height, IndexType tileWidth, IndexType tileHeight, F&& func);
+}
+
+namespace ac::core::detail
+{
+    // true if the calling thread is currently running a parallelFor body, parallelFor runs serially then.
+    inline bool& parallelWorker() noexcept
+    {
+        static thread_local bool flag = false;
+        return flag;
+    }
+    // number of threads a parallelFor called from the calling thread can use.
+    inline int parallelThreads() noexcept
+    {
+        return parallelWorker() ? 1 : runtime::threads();
+    }
+    // mark the calling thread as a parallelFor worker, or not, for the lifetime of the scope.
+    class ParallelWorkerScope
+    {
+    public:
+        explicit ParallelWorkerScope(const bool worker = true) noexcept : prev(parallelWorker()) { parallelWorker() = worker; }
+        ParallelWorkerScope(const ParallelWorkerScope&) = delete;
+        ParallelWorkerScope& operator=(const ParallelWorkerScope&) = delete;
+        ~ParallelWorkerScope() noexcept { parallelWorker() = prev; }
+    private:
+        bool prev;
+    };
+
+#if !defined(AC_CORE_PARALLEL_PPL) && !defined(AC_CORE_PARALLEL_OPENMP)
+    // number of chunks per thread when the grain is chosen automatically, more chunks balance better but cost more scheduling.
+    constexpr std::size_t ParallelChunksPerThread = 4;
+
+    // chunks are claimed from `next` by the calling thread and the helpers, `done` works as a latch the calling thread waits on.
+    // it is shared with the helpers, so a helper that starts after everything is done only touches this state.
+    // a chunk that throws still counts as done, the chunks left are skipped and the first exception is rethrown by `wait`.
+    class ParallelChunks
+    {
+    public:
+        ParallelChunks(const std::size_t chunks, void* const ctx, void (* const call)(void*, std::size_t)) noexcept : chunks(chunks), ctx(ctx), call(call) {}
+
+        void run()
+        {
+            const ParallelWorkerScope scope{};
+            for (std::size_t chunk = next++; chunk < chunks; chunk = next++)
+            {
+                if (!failed)
+                {
+                    try { call(ctx, chunk); }
+                    catch (...)
+                    {
+                        const std::lock_guard lock{ mtx };
+                        if (!error) error = std::current_exception();
+                        failed = true;
+                    }
+                }
+                if (++done == chunks)
+                {
+                    const std::lock_guard lock{ mtx };
+                    cnd.notify_all();
+                }
+            }
+        }
+        void wait()
+        {
+            std::unique_lock lock{ mtx };
+            cnd.wait(lock, [this] { return done == chunks; });
+            if (error) std::rethrow_exception(error);
+        }
+    private:
+        const std::size_t chunks;
+        void* const ctx;
+        void (* const call)(void*, std::size_t);
+        std::atomic_size_t next = 0;
+        std::atomic_size_t done = 0;
+        std::atomic_bool failed = false;
+        std::exception_ptr error{};
+        std::condition_variable cnd;
+        std::mutex mtx;
+    };
+
+    template <typename F>
+    inline void parallelChunks(const std::size_t chunks, F&& body)
+    {
+        const auto threads = static_cast<std::size_t>(parallelThreads());
+        if (threads > 1 && chunks > 1)
+        {
+            auto state = std::make_shared<ParallelChunks>(chunks, &body, [](void* const ctx, const std::size_t chunk) { (*static_cast<std::remove_reference_t<F>*>(ctx))(chunk); });
+            const std::size_t helpers = std::min(threads, chunks) - 1;
+            if (helpers) runtime::submit([state]() { state->run(); }, static_cast<int>(helpers));
+            state->run();
+            state->wait();
+        }
+        else
+        {
+            const ParallelWorkerScope scope{};
+            for (std::size_t chunk = 0; chunk < chunks; chunk++) body(chunk);
+        }
+    }
+#endif
 }
 
 template <typename IndexType, typename F>
 inline void ac::core::parallelFor(const IndexType first, const IndexType last, F&& func)
 {
 #   if defined(AC_CORE_PARALLEL_PPL)
-        Concurrency::parallel_for(first, last, std::forward<F>(func));
+        if (detail::parallelWorker()) for (IndexType i = first; i < last; i++) func(i);
+        else Concurrency::parallel_for(first, last, [&](const IndexType i) {
+            const detail::ParallelWorkerScope scope{};
+            func(i);
+        });
 #   elif defined(AC_CORE_PARALLEL_OPENMP)
-#       pragma omp parallel for
+#       pragma omp parallel for num_threads(runtime::threads()) if(!omp_in_parallel() && !detail::parallelWorker())
         for (IndexType i = first; i < last; i++) func(i);
 #   else
-        static const std::size_t threads = ac::util::ThreadPool::hardwareThreads();
-        if (threads > 1)
-        {
-            static ac::util::ThreadPool pool(threads + 1);
-            std::vector<std::future<void>> tasks{};
-            tasks.reserve(static_cast<decltype(tasks.size())>(last) - static_cast<decltype(tasks.size())>(first));
-            for (IndexType i = first; i < last; i++) tasks.emplace_back(pool.exec([&](IndexType idx) { func(idx); }, i));
-            for (auto&& task : tasks) task.wait();
-        }
-        else for (IndexType i = first; i < last; i++) func(i);
+        if (!(first < last)) return;
+        const auto count = static_cast<std::size_t>(last - first);
+        const auto chunks = std::min(count, static_cast<std::size_t>(detail::parallelThreads()) * detail::ParallelChunksPerThread);
+        parallelFor(first, last, static_cast<IndexType>((count + chunks - 1) / chunks), std::forward<F>(func));
+#   endif
+}
+template <typename IndexType, typename F>
+inline void ac::core::parallelFor(const IndexType first, const IndexType last, const IndexType grain, F&& func)
+{
+    if (!(first < last)) return;
+    const auto step = static_cast<std::size_t>(std::max(grain, static_cast<IndexType>(1)));
+    const auto chunks = (static_cast<std::size_t>(last - first) + step - 1) / step;
+    auto body = [&](const std::size_t chunk) {
+        const IndexType begin = first + static_cast<IndexType>(chunk * step);
+        const IndexType end = (last - begin) > static_cast<IndexType>(step) ? begin + static_cast<IndexType>(step) : last;
+        for (IndexType i = begin; i < end; i++) func(i);
+    };
+#   if defined(AC_CORE_PARALLEL_PPL)
+        if (detail::parallelWorker()) for (std::size_t chunk = 0; chunk < chunks; chunk++) body(chunk);
+        else Concurrency::parallel_for(static_cast<std::size_t>(0), chunks, [&](const std::size_t chunk) {
+            const detail::ParallelWorkerScope scope{};
+            body(chunk);
+        });
+#   elif defined(AC_CORE_PARALLEL_OPENMP)
+#       pragma omp parallel for schedule(dynamic) num_threads(runtime::threads()) if(!omp_in_parallel() && !detail::parallelWorker())
+        for (std::ptrdiff_t chunk = 0; chunk < static_cast<std::ptrdiff_t>(chunks); chunk++) body(static_cast<std::size_t>(chunk));
+#   else
+        detail::parallelChunks(chunks, body);
 #   endif
 }
+template <typename IndexType, typename F>
+inline void ac::core::parallelForTiles(const IndexType width, const IndexType height, const IndexType tileWidth, const IndexType tileHeight, F&& func)
+{
+    const IndexType cols = (width + tileWidth - 1) / tileWidth, rows = (height + tileHeight - 1) / tileHeight;
+    parallelFor(static_cast<IndexType>(0), cols * rows, static_cast<IndexType>(1), [&](const IndexType tile) {
+        const IndexType x = (tile % cols) * tileWidth, y = (tile / cols) * tileHeight;
+        func(x, y, std::min(tileWidth, width - x), std::min(tileHeight, height - y));
+    });
+}
 
 #endif
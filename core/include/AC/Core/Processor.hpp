@@ -1,6 +1,9 @@
 #ifndef AC_CORE_PROCESSOR_HPP
 #define AC_CORE_PROCESSOR_HPP
 
+#include <atomic>
+#include <cstddef>
+#include <functional>
 #include <memory>
 
 #include "AC/Core/Image.hpp"
@@ -19,6 +22,14 @@ public:
     static constexpr int OpenCL = 1;
     static constexpr int CUDA = 2;
 
+    // how the work of a single `process` call is run on the CPU.
+    // ExecutionSerial keeps it on the calling thread, for callers that are already parallel across frames.
+    // ExecutionParallel splits it across the compute threads of the runtime.
+    // ExecutionAuto is parallel unless it is called from inside a parallelFor.
+    static constexpr int ExecutionAuto = 0;
+    static constexpr int ExecutionSerial = 1;
+    static constexpr int ExecutionParallel = 2;
+
 public:
     AC_EXPORT Processor() noexcept;
     AC_EXPORT virtual ~Processor();
@@ -27,13 +38,43 @@ public:
     // If `dst` is not empty, then we will assume that it has been correctly allocated,
     // and the data will be guaranteed to be stored in that preallocated buffer
     AC_EXPORT void process(const Image& src, Image& dst, double factor);
+    // process a `w` x `h` source with `c` channels of `type` too large to be held in memory, in horizontal bands of whole rows.
+    // `read(y, band)` fills `band` with the source rows from `y` on, it is called for consecutive rows in order, each row once.
+    // `write(y, band)` takes the result rows from `y` on, in order, `band` is only valid during the call.
+    // the bands are read with enough rows around them for the model, so the result is the same as `process` gives,
+    // exactly for a factor of a power of 2, up to the rounding of the final resize for others. archs that round blocks of pixels together,
+    // such as AVX_WINOGRAD, may also differ by 1 for each pass of the model, as the blocks fall elsewhere in a band.
+    // the images of a band are kept within about `budget` bytes, returns false if it is too small for a band, or if `read` or `write` returns false.
+    AC_EXPORT bool processBands(int w, int h, int c, Image::ElementType type, const std::function<bool(int, Image&)>& read, const std::function<bool(int, const Image&)>& write, double factor, std::size_t budget);
+
+    AC_EXPORT void setExecutionPolicy(int policy) noexcept;
+    AC_EXPORT int executionPolicy() const noexcept;
 
     AC_EXPORT virtual bool ok() noexcept;
     AC_EXPORT virtual const char* error() noexcept;
     AC_EXPORT virtual const char* name() const noexcept = 0;
 
+    // the width or height of the result of upscaling `size` pixels by `factor`.
+    AC_EXPORT static int scaledSize(int size, double factor) noexcept;
+
 private:
     AC_EXPORT virtual void process(const Image& src, Image& dst) = 0;
+protected:
+    // `src` is RGB or RGBA, upscale its luma to `dst` and store its chroma, and alpha, to `uv` as rgb2yuv or rgba2yuva does.
+    // the default converts the whole image first, a processor may override it to convert the source as its first layer reads it.
+    AC_EXPORT virtual void process(const Image& src, Image& dst, Image& uv);
+    // upscale the luma `src` and merge it with the chroma, and alpha, `uv` resized to the same size into the RGB or RGBA `dst`.
+    // if `src` is RGB or RGBA, `uv` is ignored and its own chroma is used. the default upscales, resizes and converts in separate passes,
+    // a processor may override it to sample the chroma as it writes its last layer.
+    AC_EXPORT virtual void processToRGB(const Image& src, const Image& uv, Image& dst);
+    // an image from the scratch arena of the calling thread, it keeps its buffer across calls as long as the shape of `slot` does not change,
+    // so a steady stream of frames allocates nothing. it is only valid until the next call with the same `slot` on the same thread,
+    // so it must never be handed out to the caller. slots below `ScratchSlotUser` are used by Processor itself.
+    // the arena of a thread is freed when the thread exits.
+    // its rows start on 64 bytes, see Image::alignedStride.
+    AC_EXPORT Image scratch(int slot, int w, int h, int c, Image::ElementType type);
+
+    static constexpr int ScratchSlotUser = 64;
 
 public:
     template<int type, typename Model> static std::shared_ptr<Processor> create(int idx, const Model& model);
@@ -41,6 +82,12 @@ public:
 
 protected:
     int idx;
+private:
+    struct Scratch;
+
+    std::atomic_int policy;
+    // shared with the threads that have an arena in it, so a thread that exits can free its own
+    std::shared_ptr<Scratch> arenas;
 };
 
 #endif
@@ -0,0 +1,27 @@
+#ifndef AC_CORE_RUNTIME_HPP
+#define AC_CORE_RUNTIME_HPP
+
+#include <functional>
+
+#include "ACExport.hpp" // Generated by CMake
+
+// the process-wide compute runtime, parallel work of core and its users is scheduled on its threads.
+// it starts with the first submitted task, the configuration must be done before that.
+namespace ac::core::runtime
+{
+    // set the number of compute threads, 0 for the number of hardware threads, default is 0.
+    // returns false if the runtime has already started.
+    AC_EXPORT bool setThreads(int threads) noexcept;
+    // pin the i-th compute thread to the (i % hardware threads)-th logical processor, only works on Windows and Linux, default is false.
+    // returns false if the runtime has already started.
+    AC_EXPORT bool setAffinity(bool enable) noexcept;
+    // the number of compute threads, at least 1.
+    AC_EXPORT int threads() noexcept;
+    AC_EXPORT bool affinity() noexcept;
+    // run `task` on one of the compute threads, a task must not wait for another task that has not started yet.
+    AC_EXPORT void submit(std::function<void()> task);
+    // run `count` copies of `task`, cheaper than submitting them one by one.
+    AC_EXPORT void submit(const std::function<void()>& task, int count);
+}
+
+#endif
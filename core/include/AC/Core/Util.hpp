@@ -49,6 +49,46 @@ namespace ac::core
     // the scale ratio is assumed to be an integer.
     template<typename F, typename ...Images, std::enable_if_t<(std::is_same_v<ac::core::Image, std::remove_cv_t<Images>> && ...), bool> = true>
     void filter(F&& f, Images& ...images);
+    // filter images row by row
+    // `f(i, w, ptrs...)` is called once for each row `i` of the destination images, `w` is the width of the destination images,
+    // `ptrs` point to the first pixel of row `i` of the destination images and of row `i / scale` of the source images.
+    // source images should be passed by `const Image&` and destination images by `Image&`.
+    // the scale ratio from source images to destination images is given by `scale` and applied to both the width and height.
+    template<int scale = 1, typename F, typename ...Images, std::enable_if_t<(std::is_same_v<ac::core::Image, std::remove_cv_t<Images>> && ...), bool> = true>
+    void filterRows(F&& f, Images& ...images);
+    // filter an image block by block
+    // `f(i, j, sptr, dptrs)` is called once for each pixel (i, j) of `src`, `sptr` points to it and `dptrs[k]` points to the first pixel of row k
+    // of the `scale` x `scale` block of `dst` it maps to, so each source pixel is loaded only once.
+    // `dst` should be `scale` times the size of `src`.
+    template<int scale, typename F>
+    void filterBlocks(F&& f, const Image& src, Image& dst);
+}
+
+namespace ac::core::detail
+{
+    inline const void* offset(const void* const ptr, const int n) noexcept
+    {
+        return static_cast<const std::uint8_t*>(ptr) + n;
+    }
+    inline void* offset(void* const ptr, const int n) noexcept
+    {
+        return static_cast<std::uint8_t*>(ptr) + n;
+    }
+
+    // true if an output written to `image` should bypass the cache with non-temporal stores.
+    // it is for outputs that are not read again soon, so only those large enough to evict much of the cache.
+    inline bool nonTemporal(const Image& image) noexcept
+    {
+        return static_cast<long long>(image.stride()) * image.height() >= (1 << 19);
+    }
+
+    template<int scale, typename F, typename ...Images>
+    inline void filterPixels(F&& f, Images& ...images)
+    {
+        filterRows<scale>([&](const int i, const int w, const auto ...rows) {
+            for (int j = 0; j < w; j++) f(i, j, offset(rows, (std::is_const_v<Images> ? j / scale : j) * images.channelSize())...);
+        }, images...);
+    }
 }
 
 template <typename Integer>
@@ -110,9 +150,44 @@ inline void ac::core::filter(F&& f, Images& ...images)
     const int w = dst.width(), h = dst.height();
     const int scale = w / src.width();
 
+    switch (scale)
+    {
+    case 1: return detail::filterPixels<1>(std::forward<F>(f), images...);
+    case 2: return detail::filterPixels<2>(std::forward<F>(f), images...);
+    default:
+        parallelFor(0, h,
+            [&](const int i) {
+                for (int j = 0; j < w; j++) f(i, j, (std::is_const_v<Images> ? images.ptr(j / scale, i / scale) : images.ptr(j, i))...);
+            });
+    }
+}
+template<int scale, typename F, typename ...Images, std::enable_if_t<(std::is_same_v<ac::core::Image, std::remove_cv_t<Images>> && ...), bool>>
+inline void ac::core::filterRows(F&& f, Images& ...images)
+{
+    const auto& dst = std::get<sizeof...(Images) - 1>(std::forward_as_tuple(images...));
+
+    const int w = dst.width(), h = dst.height();
+
+    parallelFor(0, h,
+        [&](const int i) {
+            f(i, w, (std::is_const_v<Images> ? images.ptr(0, i / scale) : images.ptr(0, i))...);
+        });
+}
+template<int scale, typename F>
+inline void ac::core::filterBlocks(F&& f, const Image& src, Image& dst)
+{
+    const int w = src.width(), h = src.height();
+    const int size = scale * dst.channelSize();
+
     parallelFor(0, h,
         [&](const int i) {
-            for (int j = 0; j < w; j++) f(i, j, (std::is_const_v<Images> ? images.ptr(j / scale, i / scale) : images.ptr(j, i))...);
+            void* rows[scale];
+            for (int k = 0; k < scale; k++) rows[k] = dst.ptr(0, i * scale + k);
+            for (int j = 0; j < w; j++)
+            {
+                f(i, j, src.ptr(j, i), static_cast<void* const*>(rows));
+                for (int k = 0; k < scale; k++) rows[k] = detail::offset(rows[k], size);
+            }
         });
 }
 
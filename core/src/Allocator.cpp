@@ -0,0 +1,140 @@
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#if defined(__linux__)
+#   include <sys/mman.h>
+#endif
+
+#include "AC/Core/Allocator.hpp"
+
+namespace ac::core::allocator::detail
+{
+    constexpr std::size_t PoolMinSize = 4096;
+    constexpr std::size_t HugePageSize = static_cast<std::size_t>(2) << 20;
+    constexpr std::size_t HugePageThreshold = static_cast<std::size_t>(4) << 20;
+
+    struct Current
+    {
+        Allocator allocator = system();
+        std::mutex mtx{};
+    };
+    inline static Current& current() noexcept
+    {
+        static Current current{};
+        return current;
+    }
+
+    inline static void* systemAllocate(const std::size_t size, void* /*userdata*/) noexcept
+    {
+        return std::malloc(size);
+    }
+    inline static void systemDeallocate(void* const ptr, const std::size_t /*size*/, void* /*userdata*/) noexcept
+    {
+        std::free(ptr);
+    }
+
+    // free buffers by class size
+    struct Pool
+    {
+        std::map<std::size_t, std::vector<void*>> buffers{};
+        std::mutex mtx{};
+    };
+    inline static Pool& pool() noexcept
+    {
+        // never destroyed, images in static storage may be freed after it would be
+        static auto pool = new Pool{};
+        return *pool;
+    }
+    // round up to the next of four classes per power of two, so at most a quarter of a buffer is wasted
+    inline static std::size_t classSize(const std::size_t size) noexcept
+    {
+        if (size <= PoolMinSize) return PoolMinSize;
+        std::size_t step = PoolMinSize >> 2;
+        while ((step << 3) < size) step <<= 1;
+        return (size + step - 1) / step * step;
+    }
+    inline static void* poolAllocate(const std::size_t size, void* /*userdata*/) noexcept
+    {
+        const auto bytes = classSize(size);
+        {
+            auto& pool = detail::pool();
+            const std::lock_guard lock{ pool.mtx };
+            auto it = pool.buffers.find(bytes);
+            if (it != pool.buffers.end() && !it->second.empty())
+            {
+                auto ptr = it->second.back();
+                it->second.pop_back();
+                return ptr;
+            }
+        }
+        return std::malloc(bytes);
+    }
+    inline static void poolDeallocate(void* const ptr, const std::size_t size, void* /*userdata*/) noexcept
+    {
+        if (!ptr) return;
+        auto& pool = detail::pool();
+        const std::lock_guard lock{ pool.mtx };
+        try { pool.buffers[classSize(size)].emplace_back(ptr); }
+        catch (...) { std::free(ptr); }
+    }
+
+    inline static void* hugePageAllocate(const std::size_t size, void* const userdata) noexcept
+    {
+#   if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if (size >= HugePageThreshold)
+        {
+            // map one huge page more and cut it off, so the buffer starts on a huge page boundary
+            const auto bytes = (size + HugePageSize - 1) / HugePageSize * HugePageSize;
+            auto map = mmap(nullptr, bytes + HugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (map == MAP_FAILED) return nullptr;
+            auto addr = reinterpret_cast<std::uintptr_t>(map);
+            auto aligned = (addr + HugePageSize - 1) / HugePageSize * HugePageSize;
+            if (aligned > addr) munmap(map, aligned - addr);
+            munmap(reinterpret_cast<void*>(aligned + bytes), addr + HugePageSize - aligned);
+            auto ptr = reinterpret_cast<void*>(aligned);
+            madvise(ptr, bytes, MADV_HUGEPAGE);
+            return ptr;
+        }
+#   endif
+        return systemAllocate(size, userdata);
+    }
+    inline static void hugePageDeallocate(void* const ptr, const std::size_t size, void* const userdata) noexcept
+    {
+#   if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if (size >= HugePageThreshold)
+        {
+            if (ptr) munmap(ptr, (size + HugePageSize - 1) / HugePageSize * HugePageSize);
+            return;
+        }
+#   endif
+        systemDeallocate(ptr, size, userdata);
+    }
+}
+
+ac::core::Allocator ac::core::allocator::system() noexcept
+{
+    return { &detail::systemAllocate, &detail::systemDeallocate, nullptr };
+}
+ac::core::Allocator ac::core::allocator::pool() noexcept
+{
+    return { &detail::poolAllocate, &detail::poolDeallocate, nullptr };
+}
+ac::core::Allocator ac::core::allocator::hugePage() noexcept
+{
+    return { &detail::hugePageAllocate, &detail::hugePageDeallocate, nullptr };
+}
+void ac::core::allocator::set(const Allocator& allocator) noexcept
+{
+    auto& current = detail::current();
+    const std::lock_guard lock{ current.mtx };
+    current.allocator = allocator;
+}
+ac::core::Allocator ac::core::allocator::get() noexcept
+{
+    auto& current = detail::current();
+    const std::lock_guard lock{ current.mtx };
+    return current.allocator;
+}
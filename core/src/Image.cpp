@@ -1,11 +1,13 @@
+#include <atomic>
 #include <cstddef>
 #include <cstdlib>
 
+#include "AC/Core/Allocator.hpp"
 #include "AC/Core/Image.hpp"
 #include "AC/Core/Util.hpp"
 
 #ifndef AC_MALLOC_ALIGN
-#define AC_MALLOC_ALIGN 32
+#define AC_MALLOC_ALIGN 64
 #endif
 
 namespace ac::core::detail
@@ -16,28 +18,47 @@ namespace ac::core::detail
         return reinterpret_cast<T*>(align(reinterpret_cast<std::uintptr_t>(ptr), n));
     }
 
-    inline static void* alignedAlloc(const std::size_t size) noexcept
+    inline static std::atomic_size_t& allocationCounter() noexcept
     {
-        auto buffer = static_cast<void**>(std::malloc(size + sizeof(void*) + AC_MALLOC_ALIGN));
-        if (!buffer) return nullptr;
-        void** ptr = alignPtr(buffer + 1, AC_MALLOC_ALIGN);
-        ptr[-1] = static_cast<void*>(buffer);
-        return ptr;
+        static std::atomic_size_t counter = 0;
+        return counter;
     }
-    inline static void alignedFree(void* const ptr) noexcept
+
+    // all buffers of the core are allocated here, so they can be counted
+    void* allocate(const std::size_t size, const Allocator& allocator) noexcept
+    {
+        allocationCounter().fetch_add(1, std::memory_order_relaxed);
+        return allocator.allocate(size, allocator.userdata);
+    }
+    void deallocate(void* const ptr, const std::size_t size, const Allocator& allocator) noexcept
     {
-        if (ptr) std::free(static_cast<void**>(ptr)[-1]);
+        if (ptr) allocator.deallocate(ptr, size, allocator.userdata);
     }
 }
 
+std::size_t ac::core::detail::allocations() noexcept
+{
+    return allocationCounter().load(std::memory_order_relaxed);
+}
+
 struct ac::core::Image::ImageData
 {
+    // the allocator the buffer came from and the size asked for, with room for the alignment
+    Allocator source;
+    std::size_t bytes;
+    void* buffer;
     void* data;
+    // bytes usable from `data`
+    int capacity;
 
-    ImageData(const int size) noexcept : data(detail::alignedAlloc(size)) {}
+    ImageData(const int size) noexcept :
+        source(allocator::get()), bytes(static_cast<std::size_t>(size) + AC_MALLOC_ALIGN),
+        buffer(detail::allocate(bytes, source)),
+        data(buffer ? detail::alignPtr(buffer, AC_MALLOC_ALIGN) : nullptr),
+        capacity(buffer ? size : 0) {}
     ~ImageData() noexcept
     {
-        detail::alignedFree(data);
+        detail::deallocate(buffer, bytes, source);
     }
 };
 
@@ -73,6 +94,39 @@ void ac::core::Image::create(const int w, const int h, const int c, const Elemen
     this->c = c;
     this->elementType = elementType;
     this->pitch = pitch;
-    this->dptr = std::make_shared<ImageData>(size);
+    // keep the buffer if it is large enough and no other image shares it
+    if (!(this->dptr && this->dptr.use_count() == 1 && this->dptr->capacity >= size)) this->dptr = std::make_shared<ImageData>(size);
     this->pixels = this->dptr->data;
 }
+ac::core::Image ac::core::Image::roi(int x, int y, int w, int h) const noexcept
+{
+    // clip the rectangle to the image
+    if (x < 0)
+    {
+        w += x;
+        x = 0;
+    }
+    if (y < 0)
+    {
+        h += y;
+        y = 0;
+    }
+    if (w > this->w - x) w = this->w - x;
+    if (h > this->h - y) h = this->h - y;
+
+    Image image{};
+    if (empty() || w <= 0 || h <= 0) return image;
+    image.w = w;
+    image.h = h;
+    image.c = c;
+    image.elementType = elementType;
+    image.pitch = pitch;
+    image.pixels = ptr(x, y);
+    image.dptr = dptr;
+    return image;
+}
+int ac::core::Image::alignedStride(const int w, const int c, const ElementType elementType, const int alignment) noexcept
+{
+    const int stride = w * c * (elementType & 0xff);
+    return alignment > 1 ? align(stride, alignment) : stride;
+}
@@ -62,7 +62,12 @@ bool ac::core::imwrite(const char* const filename, const Image& image) noexcept
         if (!std::strcmp(filename + idx + 1, "bmp")) return stbi_write_bmp(filename, out.width(), out.height(), out.channels(), out.ptr());
         if (!std::strcmp(filename + idx + 1, "tga")) return stbi_write_tga(filename, out.width(), out.height(), out.channels(), out.ptr());
     }
-    else return stbi_write_jpg(filename, image.width(), image.height(), image.channels(), image.ptr(), 95);
+    else
+    {
+        Image out = image;
+        unpadding(out, out);
+        return stbi_write_jpg(filename, out.width(), out.height(), out.channels(), out.ptr(), 95);
+    }
 
     return false;
 }
@@ -1,12 +1,68 @@
 #include <cassert>
+#include <cstddef>
+#include <cstring>
 #include <type_traits>
 
-#define STB_IMAGE_RESIZE2_IMPLEMENTATION
-#include <stb_image_resize2.h>
-
+#include "AC/Core/Allocator.hpp"
 #include "AC/Core/Image.hpp"
 #include "AC/Core/Util.hpp"
 
+namespace ac::core::detail
+{
+    // defined in Image.cpp
+    void* allocate(std::size_t size, const Allocator& allocator) noexcept;
+    void deallocate(void* ptr, std::size_t size, const Allocator& allocator) noexcept;
+
+    // stb_image_resize2 allocates its work memory for every call, keep it in a buffer of the calling thread that only grows.
+    // a nested request, which stb does not make, falls back to the system allocator.
+    class ResizeBuffer
+    {
+    public:
+        ResizeBuffer() noexcept = default;
+        ResizeBuffer(const ResizeBuffer&) = delete;
+        ResizeBuffer& operator=(const ResizeBuffer&) = delete;
+        ~ResizeBuffer() noexcept { deallocate(data, capacity, source); }
+
+        static void* acquire(const std::size_t size) noexcept
+        {
+            auto& buffer = local();
+            if (buffer.used) return allocate(size, allocator::system());
+            if (buffer.capacity < size)
+            {
+                deallocate(buffer.data, buffer.capacity, buffer.source);
+                buffer.source = allocator::get();
+                buffer.data = allocate(size, buffer.source);
+                buffer.capacity = buffer.data ? size : 0;
+                if (!buffer.data) return nullptr;
+            }
+            buffer.used = true;
+            return buffer.data;
+        }
+        static void release(void* const ptr) noexcept
+        {
+            auto& buffer = local();
+            if (ptr && ptr == buffer.data) buffer.used = false;
+            else deallocate(ptr, 0, allocator::system());
+        }
+    private:
+        static ResizeBuffer& local() noexcept
+        {
+            static thread_local ResizeBuffer buffer{};
+            return buffer;
+        }
+    private:
+        Allocator source = allocator::system();
+        void* data = nullptr;
+        std::size_t capacity = 0;
+        bool used = false;
+    };
+}
+
+#define STBIR_MALLOC(size, user_data) ((void)(user_data), ac::core::detail::ResizeBuffer::acquire(size))
+#define STBIR_FREE(ptr, user_data) ((void)(user_data), ac::core::detail::ResizeBuffer::release(ptr))
+#define STB_IMAGE_RESIZE2_IMPLEMENTATION
+#include <stb_image_resize2.h>
+
 namespace ac::core::detail
 {
     inline static void resize(const Image& src, Image& dst, const double fx, const double fy) noexcept
@@ -69,270 +125,318 @@ namespace ac::core::detail
     template<typename IN, typename OUT = IN>
     inline void rgb2yuv(const Image& src, Image& dst)
     {
-        filter([](const int /*i*/, const int /*j*/, const void* const sptr, void* const dptr) {
+        const int channels[] = { src.channels(), dst.channels() };
+        filterRows([=](const int /*i*/, const int w, const void* const sptr, void* const dptr) {
             auto in = static_cast<const IN*>(sptr);
             auto out = static_cast<OUT*>(dptr);
 
-            float r = toFloat(in[0]);
-            float g = toFloat(in[1]);
-            float b = toFloat(in[2]);
+            for (int j = 0; j < w; j++, in += channels[0], out += channels[1])
+            {
+                float r = toFloat(in[0]);
+                float g = toFloat(in[1]);
+                float b = toFloat(in[2]);
 
-            float y = 0.299f * r + 0.587f * g + 0.114f * b;
-            float u = 0.564f * (b - y) + 0.5f;
-            float v = 0.713f * (r - y) + 0.5f;
+                float y = 0.299f * r + 0.587f * g + 0.114f * b;
+                float u = 0.564f * (b - y) + 0.5f;
+                float v = 0.713f * (r - y) + 0.5f;
 
-            out[0] = fromFloat<OUT>(y);
-            out[1] = fromFloat<OUT>(u);
-            out[2] = fromFloat<OUT>(v);
+                out[0] = fromFloat<OUT>(y);
+                out[1] = fromFloat<OUT>(u);
+                out[2] = fromFloat<OUT>(v);
+            }
         }, src, dst);
     }
     template<typename IN, typename OUT = IN>
     inline void rgb2yuv(const Image& src, Image& dsty, Image& dstuv)
     {
-        filter([](const int /*i*/, const int /*j*/, const void* const sptr, void* const yptr, void* const uvptr) {
+        const int channels[] = { src.channels(), dsty.channels(), dstuv.channels() };
+        filterRows([=](const int /*i*/, const int w, const void* const sptr, void* const yptr, void* const uvptr) {
             auto in = static_cast<const IN*>(sptr);
             auto yout = static_cast<OUT*>(yptr);
             auto uvout = static_cast<OUT*>(uvptr);
 
-            float r = toFloat(in[0]);
-            float g = toFloat(in[1]);
-            float b = toFloat(in[2]);
+            for (int j = 0; j < w; j++, in += channels[0], yout += channels[1], uvout += channels[2])
+            {
+                float r = toFloat(in[0]);
+                float g = toFloat(in[1]);
+                float b = toFloat(in[2]);
 
-            float y = 0.299f * r + 0.587f * g + 0.114f * b;
-            float u = 0.564f * (b - y) + 0.5f;
-            float v = 0.713f * (r - y) + 0.5f;
+                float y = 0.299f * r + 0.587f * g + 0.114f * b;
+                float u = 0.564f * (b - y) + 0.5f;
+                float v = 0.713f * (r - y) + 0.5f;
 
-            yout[0] = fromFloat<OUT>(y);
-            uvout[0] = fromFloat<OUT>(u);
-            uvout[1] = fromFloat<OUT>(v);
+                yout[0] = fromFloat<OUT>(y);
+                uvout[0] = fromFloat<OUT>(u);
+                uvout[1] = fromFloat<OUT>(v);
+            }
         }, src, dsty, dstuv);
     }
     template<typename IN, typename OUT = IN>
     inline void rgb2yuv(const Image& src, Image& dsty, Image& dstu, Image& dstv)
     {
-        filter([](const int /*i*/, const int /*j*/, const void* const sptr, void* const yptr, void* const uptr, void* const vptr) {
+        const int channels[] = { src.channels(), dsty.channels(), dstu.channels(), dstv.channels() };
+        filterRows([=](const int /*i*/, const int w, const void* const sptr, void* const yptr, void* const uptr, void* const vptr) {
             auto in = static_cast<const IN*>(sptr);
             auto yout = static_cast<OUT*>(yptr);
             auto uout = static_cast<OUT*>(uptr);
             auto vout = static_cast<OUT*>(vptr);
 
-            float r = toFloat(in[0]);
-            float g = toFloat(in[1]);
-            float b = toFloat(in[2]);
+            for (int j = 0; j < w; j++, in += channels[0], yout += channels[1], uout += channels[2], vout += channels[3])
+            {
+                float r = toFloat(in[0]);
+                float g = toFloat(in[1]);
+                float b = toFloat(in[2]);
 
-            float y = 0.299f * r + 0.587f * g + 0.114f * b;
-            float u = 0.564f * (b - y) + 0.5f;
-            float v = 0.713f * (r - y) + 0.5f;
+                float y = 0.299f * r + 0.587f * g + 0.114f * b;
+                float u = 0.564f * (b - y) + 0.5f;
+                float v = 0.713f * (r - y) + 0.5f;
 
-            *yout = fromFloat<OUT>(y);
-            *uout = fromFloat<OUT>(u);
-            *vout = fromFloat<OUT>(v);
+                *yout = fromFloat<OUT>(y);
+                *uout = fromFloat<OUT>(u);
+                *vout = fromFloat<OUT>(v);
+            }
         }, src, dsty, dstu, dstv);
     }
 
     template<typename IN, typename OUT = IN>
     inline void rgba2yuva(const Image& src, Image& dst)
     {
-        filter([](const int /*i*/, const int /*j*/, const void* const sptr, void* const dptr) {
+        const int channels[] = { src.channels(), dst.channels() };
+        filterRows([=](const int /*i*/, const int w, const void* const sptr, void* const dptr) {
             auto in = static_cast<const IN*>(sptr);
             auto out = static_cast<OUT*>(dptr);
 
-            float r = toFloat(in[0]);
-            float g = toFloat(in[1]);
-            float b = toFloat(in[2]);
-
-            float y = 0.299f * r + 0.587f * g + 0.114f * b;
-            float u = 0.564f * (b - y) + 0.5f;
-            float v = 0.713f * (r - y) + 0.5f;
-
-            out[0] = fromFloat<OUT>(y);
-            out[1] = fromFloat<OUT>(u);
-            out[2] = fromFloat<OUT>(v);
-            if constexpr (std::is_same_v<IN, OUT>) out[3] = in[3];
-            else out[3] = fromFloat<OUT>(toFloat(in[3]));
+            for (int j = 0; j < w; j++, in += channels[0], out += channels[1])
+            {
+                float r = toFloat(in[0]);
+                float g = toFloat(in[1]);
+                float b = toFloat(in[2]);
+
+                float y = 0.299f * r + 0.587f * g + 0.114f * b;
+                float u = 0.564f * (b - y) + 0.5f;
+                float v = 0.713f * (r - y) + 0.5f;
+
+                out[0] = fromFloat<OUT>(y);
+                out[1] = fromFloat<OUT>(u);
+                out[2] = fromFloat<OUT>(v);
+                if constexpr (std::is_same_v<IN, OUT>) out[3] = in[3];
+                else out[3] = fromFloat<OUT>(toFloat(in[3]));
+            }
         }, src, dst);
     }
     template<typename IN, typename OUT = IN>
     inline void rgba2yuva(const Image& src, Image& dsty, Image& dstuva)
     {
-        filter([](const int /*i*/, const int /*j*/, const void* const sptr, void* const yptr, void* const uvaptr) {
+        const int channels[] = { src.channels(), dsty.channels(), dstuva.channels() };
+        filterRows([=](const int /*i*/, const int w, const void* const sptr, void* const yptr, void* const uvaptr) {
             auto in = static_cast<const IN*>(sptr);
             auto yout = static_cast<OUT*>(yptr);
             auto uvaout = static_cast<OUT*>(uvaptr);
 
-            float r = toFloat(in[0]);
-            float g = toFloat(in[1]);
-            float b = toFloat(in[2]);
-
-            float y = 0.299f * r + 0.587f * g + 0.114f * b;
-            float u = 0.564f * (b - y) + 0.5f;
-            float v = 0.713f * (r - y) + 0.5f;
-
-            yout[0] = fromFloat<OUT>(y);
-            uvaout[0] = fromFloat<OUT>(u);
-            uvaout[1] = fromFloat<OUT>(v);
-            if constexpr (std::is_same_v<IN, OUT>) uvaout[2] = in[3];
-            else uvaout[2] = fromFloat<OUT>(toFloat(in[3]));
+            for (int j = 0; j < w; j++, in += channels[0], yout += channels[1], uvaout += channels[2])
+            {
+                float r = toFloat(in[0]);
+                float g = toFloat(in[1]);
+                float b = toFloat(in[2]);
+
+                float y = 0.299f * r + 0.587f * g + 0.114f * b;
+                float u = 0.564f * (b - y) + 0.5f;
+                float v = 0.713f * (r - y) + 0.5f;
+
+                yout[0] = fromFloat<OUT>(y);
+                uvaout[0] = fromFloat<OUT>(u);
+                uvaout[1] = fromFloat<OUT>(v);
+                if constexpr (std::is_same_v<IN, OUT>) uvaout[2] = in[3];
+                else uvaout[2] = fromFloat<OUT>(toFloat(in[3]));
+            }
         }, src, dsty, dstuva);
     }
     template<typename IN, typename OUT = IN>
     inline void rgba2yuva(const Image& src, Image& dsty, Image& dstu, Image& dstv, Image& dsta)
     {
-        filter([](const int /*i*/, const int /*j*/, const void* const sptr, void* const yptr, void* const uptr, void* const vptr, void* const aptr) {
+        const int channels[] = { src.channels(), dsty.channels(), dstu.channels(), dstv.channels(), dsta.channels() };
+        filterRows([=](const int /*i*/, const int w, const void* const sptr, void* const yptr, void* const uptr, void* const vptr, void* const aptr) {
             auto in = static_cast<const IN*>(sptr);
             auto yout = static_cast<OUT*>(yptr);
             auto uout = static_cast<OUT*>(uptr);
             auto vout = static_cast<OUT*>(vptr);
             auto aout = static_cast<OUT*>(aptr);
 
-            float r = toFloat(in[0]);
-            float g = toFloat(in[1]);
-            float b = toFloat(in[2]);
-
-            float y = 0.299f * r + 0.587f * g + 0.114f * b;
-            float u = 0.564f * (b - y) + 0.5f;
-            float v = 0.713f * (r - y) + 0.5f;
-
-            *yout = fromFloat<OUT>(y);
-            *uout = fromFloat<OUT>(u);
-            *vout = fromFloat<OUT>(v);
-            if constexpr (std::is_same_v<IN, OUT>) *aout = in[3];
-            else *aout = fromFloat<OUT>(toFloat(in[3]));
+            for (int j = 0; j < w; j++, in += channels[0], yout += channels[1], uout += channels[2], vout += channels[3], aout += channels[4])
+            {
+                float r = toFloat(in[0]);
+                float g = toFloat(in[1]);
+                float b = toFloat(in[2]);
+
+                float y = 0.299f * r + 0.587f * g + 0.114f * b;
+                float u = 0.564f * (b - y) + 0.5f;
+                float v = 0.713f * (r - y) + 0.5f;
+
+                *yout = fromFloat<OUT>(y);
+                *uout = fromFloat<OUT>(u);
+                *vout = fromFloat<OUT>(v);
+                if constexpr (std::is_same_v<IN, OUT>) *aout = in[3];
+                else *aout = fromFloat<OUT>(toFloat(in[3]));
+            }
         }, src, dsty, dstu, dstv, dsta);
     }
 
     template<typename IN, typename OUT = IN>
     inline void yuv2rgb(const Image& src, Image& dst)
     {
-        filter([](const int /*i*/, const int /*j*/, const void* const sptr, void* const dptr) {
+        const int channels[] = { src.channels(), dst.channels() };
+        filterRows([=](const int /*i*/, const int w, const void* const sptr, void* const dptr) {
             auto in = static_cast<const IN*>(sptr);
             auto out = static_cast<OUT*>(dptr);
 
-            float y = toFloat(in[0]);
-            float u = toFloat(in[1]) - 0.5f;
-            float v = toFloat(in[2]) - 0.5f;
+            for (int j = 0; j < w; j++, in += channels[0], out += channels[1])
+            {
+                float y = toFloat(in[0]);
+                float u = toFloat(in[1]) - 0.5f;
+                float v = toFloat(in[2]) - 0.5f;
 
-            float r = y + 1.403f * v;
-            float g = y - 0.344f * u - 0.714f * v;
-            float b = y + 1.773f * u;
+                float r = y + 1.403f * v;
+                float g = y - 0.344f * u - 0.714f * v;
+                float b = y + 1.773f * u;
 
-            out[0] = fromFloat<OUT>(r);
-            out[1] = fromFloat<OUT>(g);
-            out[2] = fromFloat<OUT>(b);
+                out[0] = fromFloat<OUT>(r);
+                out[1] = fromFloat<OUT>(g);
+                out[2] = fromFloat<OUT>(b);
+            }
         }, src, dst);
     }
     template<typename IN, typename OUT = IN>
     inline void yuv2rgb(const Image& srcy, const Image& srcuv, Image& dst)
     {
-        filter([](const int /*i*/, const int /*j*/, const void* const yptr, const void* const uvptr, void* const dptr) {
+        const int channels[] = { srcy.channels(), srcuv.channels(), dst.channels() };
+        filterRows([=](const int /*i*/, const int w, const void* const yptr, const void* const uvptr, void* const dptr) {
             auto yin = static_cast<const IN*>(yptr);
             auto uvin = static_cast<const IN*>(uvptr);
             auto out = static_cast<OUT*>(dptr);
 
-            float y = toFloat(yin[0]);
-            float u = toFloat(uvin[0]) - 0.5f;
-            float v = toFloat(uvin[1]) - 0.5f;
+            for (int j = 0; j < w; j++, yin += channels[0], uvin += channels[1], out += channels[2])
+            {
+                float y = toFloat(yin[0]);
+                float u = toFloat(uvin[0]) - 0.5f;
+                float v = toFloat(uvin[1]) - 0.5f;
 
-            float r = y + 1.403f * v;
-            float g = y - 0.344f * u - 0.714f * v;
-            float b = y + 1.773f * u;
+                float r = y + 1.403f * v;
+                float g = y - 0.344f * u - 0.714f * v;
+                float b = y + 1.773f * u;
 
-            out[0] = fromFloat<OUT>(r);
-            out[1] = fromFloat<OUT>(g);
-            out[2] = fromFloat<OUT>(b);
+                out[0] = fromFloat<OUT>(r);
+                out[1] = fromFloat<OUT>(g);
+                out[2] = fromFloat<OUT>(b);
+            }
         }, srcy, srcuv, dst);
     }
     template<typename IN, typename OUT = IN>
     inline void yuv2rgb(const Image& srcy, const Image& srcu, const Image& srcv, Image& dst)
     {
-        filter([](const int /*i*/, const int /*j*/, const void* const yptr, const void* const uptr, const void* const vptr, void* const dptr) {
+        const int channels[] = { srcy.channels(), srcu.channels(), srcv.channels(), dst.channels() };
+        filterRows([=](const int /*i*/, const int w, const void* const yptr, const void* const uptr, const void* const vptr, void* const dptr) {
             auto yin = static_cast<const IN*>(yptr);
             auto uin = static_cast<const IN*>(uptr);
             auto vin = static_cast<const IN*>(vptr);
             auto out = static_cast<OUT*>(dptr);
 
-            float y = toFloat(*yin);
-            float u = toFloat(*uin) - 0.5f;
-            float v = toFloat(*vin) - 0.5f;
+            for (int j = 0; j < w; j++, yin += channels[0], uin += channels[1], vin += channels[2], out += channels[3])
+            {
+                float y = toFloat(*yin);
+                float u = toFloat(*uin) - 0.5f;
+                float v = toFloat(*vin) - 0.5f;
 
-            float r = y + 1.403f * v;
-            float g = y - 0.344f * u - 0.714f * v;
-            float b = y + 1.773f * u;
+                float r = y + 1.403f * v;
+                float g = y - 0.344f * u - 0.714f * v;
+                float b = y + 1.773f * u;
 
-            out[0] = fromFloat<OUT>(r);
-            out[1] = fromFloat<OUT>(g);
-            out[2] = fromFloat<OUT>(b);
+                out[0] = fromFloat<OUT>(r);
+                out[1] = fromFloat<OUT>(g);
+                out[2] = fromFloat<OUT>(b);
+            }
         }, srcy, srcu, srcv, dst);
     }
 
     template<typename IN, typename OUT = IN>
     inline void yuva2rgba(const Image& src, Image& dst)
     {
-        filter([](const int /*i*/, const int /*j*/, const void* const sptr, void* const dptr) {
+        const int channels[] = { src.channels(), dst.channels() };
+        filterRows([=](const int /*i*/, const int w, const void* const sptr, void* const dptr) {
             auto in = static_cast<const IN*>(sptr);
             auto out = static_cast<OUT*>(dptr);
 
-            float y = toFloat(in[0]);
-            float u = toFloat(in[1]) - 0.5f;
-            float v = toFloat(in[2]) - 0.5f;
-
-            float r = y + 1.403f * v;
-            float g = y - 0.344f * u - 0.714f * v;
-            float b = y + 1.773f * u;
-
-            out[0] = fromFloat<OUT>(r);
-            out[1] = fromFloat<OUT>(g);
-            out[2] = fromFloat<OUT>(b);
-            if constexpr (std::is_same_v<IN, OUT>) out[3] = in[3];
-            else out[3] = fromFloat<OUT>(toFloat(in[3]));
+            for (int j = 0; j < w; j++, in += channels[0], out += channels[1])
+            {
+                float y = toFloat(in[0]);
+                float u = toFloat(in[1]) - 0.5f;
+                float v = toFloat(in[2]) - 0.5f;
+
+                float r = y + 1.403f * v;
+                float g = y - 0.344f * u - 0.714f * v;
+                float b = y + 1.773f * u;
+
+                out[0] = fromFloat<OUT>(r);
+                out[1] = fromFloat<OUT>(g);
+                out[2] = fromFloat<OUT>(b);
+                if constexpr (std::is_same_v<IN, OUT>) out[3] = in[3];
+                else out[3] = fromFloat<OUT>(toFloat(in[3]));
+            }
         }, src, dst);
     }
     template<typename IN, typename OUT = IN>
     inline void yuva2rgba(const Image& srcy, const Image& srcuva, Image& dst)
     {
-        filter([](const int /*i*/, const int /*j*/, const void* const yptr, const void* const uvaptr, void* const dptr) {
+        const int channels[] = { srcy.channels(), srcuva.channels(), dst.channels() };
+        filterRows([=](const int /*i*/, const int w, const void* const yptr, const void* const uvaptr, void* const dptr) {
             auto yin = static_cast<const IN*>(yptr);
             auto uvain = static_cast<const IN*>(uvaptr);
             auto out = static_cast<OUT*>(dptr);
 
-            float y = toFloat(yin[0]);
-            float u = toFloat(uvain[0]) - 0.5f;
-            float v = toFloat(uvain[1]) - 0.5f;
-
-            float r = y + 1.403f * v;
-            float g = y - 0.344f * u - 0.714f * v;
-            float b = y + 1.773f * u;
-
-            out[0] = fromFloat<OUT>(r);
-            out[1] = fromFloat<OUT>(g);
-            out[2] = fromFloat<OUT>(b);
-            if constexpr (std::is_same_v<IN, OUT>) out[3] = uvain[2];
-            else out[3] = fromFloat<OUT>(toFloat(uvain[2]));
+            for (int j = 0; j < w; j++, yin += channels[0], uvain += channels[1], out += channels[2])
+            {
+                float y = toFloat(yin[0]);
+                float u = toFloat(uvain[0]) - 0.5f;
+                float v = toFloat(uvain[1]) - 0.5f;
+
+                float r = y + 1.403f * v;
+                float g = y - 0.344f * u - 0.714f * v;
+                float b = y + 1.773f * u;
+
+                out[0] = fromFloat<OUT>(r);
+                out[1] = fromFloat<OUT>(g);
+                out[2] = fromFloat<OUT>(b);
+                if constexpr (std::is_same_v<IN, OUT>) out[3] = uvain[2];
+                else out[3] = fromFloat<OUT>(toFloat(uvain[2]));
+            }
         }, srcy, srcuva, dst);
     }
     template<typename IN, typename OUT = IN>
     inline void yuva2rgba(const Image& srcy, const Image& srcu, const Image& srcv, const Image& srca, Image& dst)
     {
-        filter([](const int /*i*/, const int /*j*/, const void* const yptr, const void* const uptr, const void* const vptr, const void* const aptr, void* const dptr) {
+        const int channels[] = { srcy.channels(), srcu.channels(), srcv.channels(), srca.channels(), dst.channels() };
+        filterRows([=](const int /*i*/, const int w, const void* const yptr, const void* const uptr, const void* const vptr, const void* const aptr, void* const dptr) {
             auto yin = static_cast<const IN*>(yptr);
             auto uin = static_cast<const IN*>(uptr);
             auto vin = static_cast<const IN*>(vptr);
             auto ain = static_cast<const IN*>(aptr);
             auto out = static_cast<OUT*>(dptr);
 
-            float y = toFloat(*yin);
-            float u = toFloat(*uin) - 0.5f;
-            float v = toFloat(*vin) - 0.5f;
-
-            float r = y + 1.403f * v;
-            float g = y - 0.344f * u - 0.714f * v;
-            float b = y + 1.773f * u;
-
-            out[0] = fromFloat<OUT>(r);
-            out[1] = fromFloat<OUT>(g);
-            out[2] = fromFloat<OUT>(b);
-            if constexpr (std::is_same_v<IN, OUT>) out[3] = *ain;
-            else out[3] = fromFloat<OUT>(toFloat(*ain));
+            for (int j = 0; j < w; j++, yin += channels[0], uin += channels[1], vin += channels[2], ain += channels[3], out += channels[4])
+            {
+                float y = toFloat(*yin);
+                float u = toFloat(*uin) - 0.5f;
+                float v = toFloat(*vin) - 0.5f;
+
+                float r = y + 1.403f * v;
+                float g = y - 0.344f * u - 0.714f * v;
+                float b = y + 1.773f * u;
+
+                out[0] = fromFloat<OUT>(r);
+                out[1] = fromFloat<OUT>(g);
+                out[2] = fromFloat<OUT>(b);
+                if constexpr (std::is_same_v<IN, OUT>) out[3] = *ain;
+                else out[3] = fromFloat<OUT>(toFloat(*ain));
+            }
         }, srcy, srcu, srcv, srca, dst);
     }
 
@@ -340,11 +444,8 @@ namespace ac::core::detail
     inline void unpadding(const Image& src, Image& dst)
     {
         int channels = src.channels();
-        filter([=](const int /*i*/, const int /*j*/, const void* const sptr, void* const dptr) {
-            auto in = static_cast<const T*>(sptr);
-            auto out = static_cast<T*>(dptr);
-
-            for (int c = 0; c < channels; c++) out[c] = in[c];
+        filterRows([=](const int /*i*/, const int w, const void* const sptr, void* const dptr) {
+            std::memcpy(dptr, sptr, sizeof(T) * w * channels);
         }, src, dst);
     }
 
@@ -352,23 +453,23 @@ namespace ac::core::detail
     inline void shl(const Image& src, Image& dst, const int n)
     {
         int channels = src.channels();
-        filter([=](const int /*i*/, const int /*j*/, const void* const sptr, void* const dptr) {
+        filterRows([=](const int /*i*/, const int w, const void* const sptr, void* const dptr) {
             auto in = static_cast<const IN*>(sptr);
             auto out = static_cast<OUT*>(dptr);
 
-            for (int c = 0; c < channels; c++) out[c] = in[c] << n;
-            }, src, dst);
+            for (int k = 0; k < w * channels; k++) out[k] = in[k] << n;
+        }, src, dst);
     }
     template<typename IN, typename OUT = IN>
     inline void shr(const Image& src, Image& dst, const int n)
     {
         int channels = src.channels();
-        filter([=](const int /*i*/, const int /*j*/, const void* const sptr, void* const dptr) {
+        filterRows([=](const int /*i*/, const int w, const void* const sptr, void* const dptr) {
             auto in = static_cast<const IN*>(sptr);
             auto out = static_cast<OUT*>(dptr);
 
-            for (int c = 0; c < channels; c++) out[c] = in[c] >> n;
-            }, src, dst);
+            for (int k = 0; k < w * channels; k++) out[k] = in[k] >> n;
+        }, src, dst);
     }
 }
 
@@ -1,7 +1,75 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "AC/Core/Parallel.hpp"
 #include "AC/Core/Processor.hpp"
 #include "AC/Core/Util.hpp"
 
-ac::core::Processor::Processor() noexcept : idx(0) {}
+// rows of the scratch images start on this many bytes, 0 to pack them
+#ifndef AC_CORE_ROW_ALIGN
+#define AC_CORE_ROW_ALIGN 64
+#endif
+
+// source rows read above and below each band of processBands, they cover what the 9 conv3x3 layers of every pass
+// and the resize after them see around a pixel, at most 9 + 9 / 2 + 9 / 4 + ... + 1 rows
+#ifndef AC_CORE_BAND_OVERLAP
+#define AC_CORE_BAND_OVERLAP 20
+#endif
+
+namespace ac::core::detail
+{
+    // scratch slots of Processor itself
+    enum
+    {
+        ScratchChroma,
+        ScratchLuma,
+        ScratchUpscaled,
+        ScratchScaled,
+        ScratchResized,
+        ScratchBandSource,
+        ScratchBandResult,
+        ScratchPass // the output of each pass has a slot from here on
+    };
+
+    // upscale by 2 to the power of `power` with the network, then resize by `fxy`
+    inline static void split(const double factor, int& power, double& fxy) noexcept
+    {
+        power = factor > 2.0 ? ceilLog2(factor) : 1;
+        fxy = factor / static_cast<double>(1 << power);
+    }
+}
+
+// one arena per thread, only the thread itself touches its arena, the lock guards the map
+struct ac::core::Processor::Scratch
+{
+    // the processors the thread has an arena in, the arenas are freed when the thread exits, or with their processor if that goes first
+    struct Owner
+    {
+        std::vector<std::weak_ptr<Scratch>> scratches{};
+
+        ~Owner() noexcept
+        {
+            const auto id = std::this_thread::get_id();
+            for (auto&& weak : scratches)
+                if (auto scratch = weak.lock())
+                {
+                    const std::lock_guard lock{ scratch->mtx };
+                    scratch->arenas.erase(id);
+                }
+        }
+    };
+
+    std::unordered_map<std::thread::id, std::vector<Image>> arenas{};
+    std::mutex mtx{};
+};
+
+ac::core::Processor::Processor() noexcept : idx(0), policy(ExecutionAuto), arenas(std::make_shared<Scratch>()) {}
 ac::core::Processor::~Processor() = default;
 
 ac::core::Image ac::core::Processor::process(const Image& src, const double factor)
@@ -12,82 +80,170 @@ ac::core::Image ac::core::Processor::process(const Image& src, const double fact
 }
 void ac::core::Processor::process(const Image& src, Image& dst, const double factor)
 {
+    const int executionPolicy = policy;
+    const detail::ParallelWorkerScope scope{ executionPolicy == ExecutionAuto ? detail::parallelWorker() : executionPolicy == ExecutionSerial };
+
     Image in{}, out{ src };
     Image uv{};
 
-    int power = factor > 2.0 ? ceilLog2(factor) : 1;
-    double fxy = factor / static_cast<double>(1 << power);
+    int power = 0;
+    double fxy = 0.0;
+    detail::split(factor, power, fxy);
 
-    if (src.channels() > 1)
-    {
-        Image y{};
-        if (src.channels() == 4) rgba2yuva(src, y, uv);
-        else rgb2yuv(src, y, uv);
-        out = y;
-    }
+    // the result is the only image that is not taken from the scratch arena
+    if (dst.empty()) dst.create(scaledSize(src.width(), factor), scaledSize(src.height(), factor), src.channels(), src.type());
+    if (src.channels() > 1) uv = scratch(detail::ScratchChroma, src.width(), src.height(), src.channels() - 1, src.type());
+
+    // the last pass writes RGB[A] directly when its luma needs no further resize
+    const bool merge = src.channels() > 1 && fxy == 1.0;
+    int pass = 0;
+    // the first pass over an RGB[A] source also splits off its chroma
+    auto upscale = [&]() {
+        in = out;
+        out = scratch(detail::ScratchPass + pass++, in.width() * 2, in.height() * 2, 1, in.type());
+        if (in.channels() > 1) process(in, out, uv);
+        else process(in, out);
+    };
 
-    if (!dst.empty())
+    if (src.channels() == 1) //grey
     {
-        if (src.channels() == 1) //grey
+        if (fxy == 1.0)
         {
-            if (fxy == 1.0)
-            {
-                for (int i = 0; i < power - 1; i++)
-                {
-                    in = out;
-                    out.create(in.width() * 2, in.height() * 2, 1, in.type());
-                    process(in, out);
-                }
-                process(out, dst);
-            }
-            else
-            {
-                for (int i = 0; i < power; i++)
-                {
-                    in = out;
-                    out.create(in.width() * 2, in.height() * 2, 1, in.type());
-                    process(in, out);
-                }
-                resize(out, dst, 0.0, 0.0);
-            }
+            for (int i = 0; i < power - 1; i++) upscale();
+            process(out, dst);
         }
-        else //rgb[a]
+        else
         {
-            for (int i = 0; i < power; i++)
-            {
-                in = out;
-                out.create(in.width() * 2, in.height() * 2, 1, in.type());
-                process(in, out);
-            }
-
-            if (fxy != 1.0) resize(out, out, fxy, fxy);
-
-            resize(uv, uv, factor, factor);
-            if (src.channels() == 4) yuva2rgba(out, uv, dst);
-            else yuv2rgb(out, uv, dst);
+            for (int i = 0; i < power; i++) upscale();
+            resize(out, dst, 0.0, 0.0);
         }
     }
-    else
+    else if (merge) //rgb[a]
     {
-        for (int i = 0; i < power; i++)
-        {
-            in = out;
-            out.create(in.width() * 2, in.height() * 2, 1, in.type());
-            process(in, out);
-        }
+        for (int i = 0; i < power - 1; i++) upscale();
+        processToRGB(out, uv, dst);
+    }
+    else //rgb[a]
+    {
+        for (int i = 0; i < power; i++) upscale();
+
+        Image luma = scratch(detail::ScratchResized, static_cast<int>(out.width() * fxy), static_cast<int>(out.height() * fxy), 1, out.type());
+        resize(out, luma, 0.0, 0.0);
+        Image chroma = scratch(detail::ScratchScaled, luma.width(), luma.height(), uv.channels(), uv.type());
+        resize(uv, chroma, 0.0, 0.0);
+        if (src.channels() == 4) yuva2rgba(luma, chroma, dst);
+        else yuv2rgb(luma, chroma, dst);
+    }
+}
+bool ac::core::Processor::processBands(const int w, const int h, const int c, const Image::ElementType type, const std::function<bool(int, Image&)>& read, const std::function<bool(int, const Image&)>& write, const double factor, const std::size_t budget)
+{
+    if (w <= 0 || h <= 0 || !(factor > 0.0)) return false;
 
-        resize(out, dst, fxy, fxy);
+    int power = 0;
+    double fxy = 0.0;
+    detail::split(factor, power, fxy);
 
-        if (src.channels() > 1)
-        {
-            Image rgb{};
-            resize(uv, uv, factor, factor);
-            if (src.channels() == 4) yuva2rgba(dst, uv, rgb);
-            else yuv2rgb(dst, uv, rgb);
-            dst = rgb;
-        }
+    // bands start on a multiple of `step` rows, the fewest that map to a whole number of output rows,
+    // so a band samples the source exactly as the whole image does. a factor without one in reach falls back to single rows.
+    int step = 1;
+    while (step < 64 && std::abs(factor * step - std::round(factor * step)) > 1e-9) step++;
+    if (step == 64) step = 1;
+    const int overlap = (AC_CORE_BAND_OVERLAP + step - 1) / step * step;
+
+    // bytes a band needs per source row: the source with its luma and chroma, the passes, the luma and chroma at the upscaled size,
+    // the result with its resized luma, and two 8-channel float feature maps at the size of the last pass
+    const double area = static_cast<double>(1 << power) * (1 << power);
+    const double elementSize = type & 0xff;
+    const double rowBytes = w * (elementSize * (2.0 * c + area * (c + 2) + factor * factor * (c + 1)) + 16.0 * area);
+    int rows = static_cast<int>(std::min(static_cast<double>(budget) / rowBytes - 2.0 * overlap, static_cast<double>(h)));
+    if (rows < h) rows = rows / step * step;
+    if (rows <= 0) return false;
+
+    const int outW = scaledSize(w, factor);
+    const int bandH = std::min(rows + 2 * overlap, h);
+    Image in = scratch(detail::ScratchBandSource, w, bandH, c, type);
+    Image out = scratch(detail::ScratchBandResult, outW, scaledSize(bandH, factor), c, type);
+    const auto size = static_cast<std::size_t>(w) * in.channelSize();
+
+    // `in` holds the source rows [a, b)
+    int a = 0, b = 0;
+    for (int y0 = 0; y0 < h; y0 += rows)
+    {
+        const int y1 = std::min(y0 + rows, h);
+        const int na = std::max(y0 - overlap, 0), nb = std::min(y1 + overlap, h);
+        // the rows shared with the last band move to the top, only the new ones are read
+        for (int i = na; i < b; i++) std::memmove(in.ptr(0, i - na), in.ptr(0, i - a), size);
+        const int first = std::max(b, na);
+        Image band = in.roi(0, first - na, w, nb - first);
+        if (!band.empty() && !read(first, band)) return false;
+        a = na;
+        b = nb;
+
+        Image result = out.roi(0, 0, outW, scaledSize(b - a, factor));
+        process(in.roi(0, 0, w, b - a), result, factor);
+        if (!ok()) return false;
+        // the band ends where row `b` of the source does in the whole result
+        const int offset = scaledSize(b, factor) - result.height();
+        const int top = scaledSize(y0, factor), bottom = scaledSize(y1, factor);
+        if (bottom > top && !write(top, result.roi(0, top - offset, outW, bottom - top))) return false;
+    }
+    return true;
+}
+void ac::core::Processor::process(const Image& src, Image& dst, Image& uv)
+{
+    Image y = scratch(detail::ScratchLuma, src.width(), src.height(), 1, src.type());
+    if (src.channels() == 4) rgba2yuva(src, y, uv);
+    else rgb2yuv(src, y, uv);
+    process(y, dst);
+}
+void ac::core::Processor::processToRGB(const Image& src, const Image& uv, Image& dst)
+{
+    Image y = scratch(detail::ScratchUpscaled, src.width() * 2, src.height() * 2, 1, src.type()), chroma{ uv };
+    if (src.channels() > 1) process(src, y, chroma);
+    else process(src, y);
+    Image scaled = scratch(detail::ScratchScaled, y.width(), y.height(), chroma.channels(), chroma.type());
+    resize(chroma, scaled, 0.0, 0.0);
+    if (chroma.channels() == 3) yuva2rgba(y, scaled, dst);
+    else yuv2rgb(y, scaled, dst);
+}
+ac::core::Image ac::core::Processor::scratch(const int slot, const int w, const int h, const int c, const Image::ElementType type)
+{
+    std::vector<Image>* arena = nullptr;
+    bool created = false;
+    {
+        const std::lock_guard lock{ arenas->mtx };
+        auto [it, inserted] = arenas->arenas.try_emplace(std::this_thread::get_id());
+        arena = &it->second; // the elements of an unordered_map never move
+        created = inserted;
+    }
+    if (created)
+    {
+        static thread_local Scratch::Owner owner{};
+        auto& scratches = owner.scratches;
+        scratches.erase(std::remove_if(scratches.begin(), scratches.end(), [](const std::weak_ptr<Scratch>& weak) { return weak.expired(); }), scratches.end());
+        scratches.emplace_back(arenas);
     }
+    if (arena->size() <= static_cast<std::size_t>(slot)) arena->resize(slot + 1);
+    auto& image = (*arena)[slot];
+    if (image.width() != w || image.height() != h || image.channels() != c || image.type() != type) image.create(w, h, c, type, Image::alignedStride(w, c, type, AC_CORE_ROW_ALIGN));
+    return image;
 }
+int ac::core::Processor::scaledSize(const int size, const double factor) noexcept
+{
+    int power = 0;
+    double fxy = 0.0;
+    detail::split(factor, power, fxy);
+    return static_cast<int>(size * (1 << power) * fxy);
+}
+void ac::core::Processor::setExecutionPolicy(const int policy) noexcept
+{
+    this->policy = policy;
+}
+int ac::core::Processor::executionPolicy() const noexcept
+{
+    return policy;
+}
+
 bool ac::core::Processor::ok() noexcept
 {
     return true;
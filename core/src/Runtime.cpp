@@ -0,0 +1,100 @@
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#if defined(_WIN32)
+#   include <windows.h>
+#elif defined(__linux__)
+#   include <pthread.h>
+#   include <sched.h>
+#endif
+
+#include "AC/Core/Runtime.hpp"
+#include "AC/Util/ThreadPool.hpp"
+
+namespace ac::core::runtime::detail
+{
+    // the pool is only created once, so it is read without the lock after that.
+    struct Runtime
+    {
+        std::atomic_int threads = 0;
+        std::atomic_bool affinity = false;
+        std::atomic<util::ThreadPool*> pool = nullptr;
+        std::unique_ptr<util::ThreadPool> owner{};
+        std::mutex mtx{};
+    };
+
+    inline static Runtime& runtime() noexcept
+    {
+        static Runtime runtime{};
+        return runtime;
+    }
+
+    inline static void pin([[maybe_unused]] const std::size_t idx) noexcept
+    {
+        [[maybe_unused]] const auto cpu = idx % util::ThreadPool::hardwareThreads();
+#   if defined(_WIN32)
+        if (cpu < sizeof(DWORD_PTR) * 8) SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << cpu);
+#   elif defined(__linux__)
+        if (cpu < CPU_SETSIZE)
+        {
+            cpu_set_t set{};
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        }
+#   endif
+    }
+
+    inline static util::ThreadPool& pool()
+    {
+        auto& runtime = detail::runtime();
+        if (auto pool = runtime.pool.load(std::memory_order_acquire)) return *pool;
+        const std::lock_guard lock{ runtime.mtx };
+        if (!runtime.owner)
+        {
+            const auto size = static_cast<std::size_t>(runtime.threads > 0 ? runtime.threads.load() : static_cast<int>(util::ThreadPool::hardwareThreads()));
+            if (runtime.affinity) runtime.owner = std::make_unique<util::ThreadPool>(size, &pin);
+            else runtime.owner = std::make_unique<util::ThreadPool>(size);
+            runtime.pool.store(runtime.owner.get(), std::memory_order_release);
+        }
+        return *runtime.owner;
+    }
+}
+
+bool ac::core::runtime::setThreads(const int threads) noexcept
+{
+    auto& runtime = detail::runtime();
+    const std::lock_guard lock{ runtime.mtx };
+    if (runtime.owner) return false;
+    runtime.threads = threads > 0 ? threads : 0;
+    return true;
+}
+bool ac::core::runtime::setAffinity(const bool enable) noexcept
+{
+    auto& runtime = detail::runtime();
+    const std::lock_guard lock{ runtime.mtx };
+    if (runtime.owner) return false;
+    runtime.affinity = enable;
+    return true;
+}
+int ac::core::runtime::threads() noexcept
+{
+    static const int hardwareThreads = static_cast<int>(util::ThreadPool::hardwareThreads());
+    const int threads = detail::runtime().threads;
+    return threads > 0 ? threads : hardwareThreads;
+}
+bool ac::core::runtime::affinity() noexcept
+{
+    return detail::runtime().affinity;
+}
+void ac::core::runtime::submit(std::function<void()> task)
+{
+    detail::pool().exec(std::move(task));
+}
+void ac::core::runtime::submit(const std::function<void()>& task, const int count)
+{
+    if (count > 0) detail::pool().execBulk(static_cast<std::size_t>(count), task);
+}
@@ -1,13 +1,23 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <sstream>
 
 #include "AC/Core/Dispatch.hpp"
+#include "AC/Core/Parallel.hpp"
 #include "AC/Core/Processor.hpp"
+#include "AC/Core/Util.hpp"
 #include "AC/Core/Model/ACNet.hpp"
 
 #include "ACExport.hpp" // Generated by CMake
 
+// edge length of the tiles used by the layer-fused execution, 0 to disable it
+#ifndef AC_CORE_CPU_TILE_SIZE
+#define AC_CORE_CPU_TILE_SIZE 96
+#endif
+
 namespace ac::core::cpu
 {
     namespace arch
@@ -20,12 +30,28 @@ namespace ac::core::cpu
 #           endif
 #           ifdef AC_CORE_WITH_SSE
             SSE,
+            SSE_BROADCAST,
 #           endif
 #           ifdef AC_CORE_WITH_AVX
             AVX,
+            AVX_BROADCAST,
+            AVX_WINOGRAD,
+            AVX_GEMM,
+#               ifdef AC_CORE_WITH_F16C
+                AVX_FP16,
+#               endif
+#           endif
+#           ifdef AC_CORE_WITH_AVX2
+            AVX2_INT8,
+#           endif
+#           ifdef AC_CORE_WITH_AVX512
+            AVX512,
 #           endif
 #           ifdef AC_CORE_WITH_NEON
             NEON,
+#               if defined(__aarch64__) || defined(_M_ARM64)
+                NEON_FP16,
+#               endif
 #           endif
 #           ifdef AC_CORE_WITH_WASM_SIMD128
             WASM_SIMD128,
@@ -41,12 +67,28 @@ namespace ac::core::cpu
 #           endif
 #           ifdef AC_CORE_WITH_SSE
             "SSE",
+            "SSE_BROADCAST",
 #           endif
 #           ifdef AC_CORE_WITH_AVX
             "AVX",
+            "AVX_BROADCAST",
+            "AVX_WINOGRAD",
+            "AVX_GEMM",
+#               ifdef AC_CORE_WITH_F16C
+                "AVX_FP16",
+#               endif
+#           endif
+#           ifdef AC_CORE_WITH_AVX2
+            "AVX2_INT8",
+#           endif
+#           ifdef AC_CORE_WITH_AVX512
+            "AVX512",
 #           endif
 #           ifdef AC_CORE_WITH_NEON
             "NEON",
+#               if defined(__aarch64__) || defined(_M_ARM64)
+                "NEON_FP16",
+#               endif
 #           endif
 #           ifdef AC_CORE_WITH_WASM_SIMD128
             "WASM_SIMD128",
@@ -54,9 +96,17 @@ namespace ac::core::cpu
             "Generic"
         };
     }
+    // the source of conv3x3_8to8 must have a 1-pixel replicated border, see detail::replicateBorder
+    // a kernel with a `_pack` function reads the weights in its own layout, `<kernel>_pack(kernels, packed)` converts the weights of one layer
+    // of the model to it and returns its size in floats, it only returns the size if `packed` is null. The packed weights are 64-byte aligned.
+    // length of the requantization parameters of a quantized layer, a multiplier and a bias for each of the 8 output channels
+    constexpr int int8ParamsLength = 16;
+    // `conv3x3_8to8_deconv2x2_8to1_<arch>(src, dst, kernels, biases, deconvKernels)` runs the last conv3x3_8to8 and deconv2x2_8to1 in one pass,
+    // the weights are the same as those of the two layers, it is optional.
     void conv3x3_1to8_generic(const Image& src, Image& dst, const float* kernels, const float* biases);
     void conv3x3_8to8_generic(const Image& src, Image& dst, const float* kernels, const float* biases);
     void deconv2x2_8to1_generic(const Image& src, Image& dst, const float* kernels);
+    void conv3x3_8to8_deconv2x2_8to1_generic(const Image& src, Image& dst, const float* kernels, const float* biases, const float* deconvKernels);
 #ifdef AC_CORE_WITH_EIGEN3
     void conv3x3_1to8_eigen3(const Image& src, Image& dst, const float* kernels, const float* biases);
     void conv3x3_8to8_eigen3(const Image& src, Image& dst, const float* kernels, const float* biases);
@@ -66,16 +116,74 @@ namespace ac::core::cpu
     void conv3x3_1to8_sse(const Image& src, Image& dst, const float* kernels, const float* biases);
     void conv3x3_8to8_sse(const Image& src, Image& dst, const float* kernels, const float* biases);
     void deconv2x2_8to1_sse(const Image& src, Image& dst, const float* kernels);
+    void conv3x3_8to8_deconv2x2_8to1_sse(const Image& src, Image& dst, const float* kernels, const float* biases, const float* deconvKernels);
+    int conv3x3_1to8_sse_pack(const float* kernels, float* packed);
+    int conv3x3_8to8_sse_pack(const float* kernels, float* packed);
+    int deconv2x2_8to1_sse_pack(const float* kernels, float* packed);
+    // vectorized over output channels, no horizontal sum
+    void conv3x3_1to8_sse_broadcast(const Image& src, Image& dst, const float* kernels, const float* biases);
+    void conv3x3_8to8_sse_broadcast(const Image& src, Image& dst, const float* kernels, const float* biases);
+    int conv3x3_1to8_sse_broadcast_pack(const float* kernels, float* packed);
+    int conv3x3_8to8_sse_broadcast_pack(const float* kernels, float* packed);
 #endif
 #ifdef AC_CORE_WITH_AVX
     void conv3x3_1to8_avx(const Image& src, Image& dst, const float* kernels, const float* biases);
     void conv3x3_8to8_avx(const Image& src, Image& dst, const float* kernels, const float* biases);
     void deconv2x2_8to1_avx(const Image& src, Image& dst, const float* kernels);
+    void conv3x3_8to8_deconv2x2_8to1_avx(const Image& src, Image& dst, const float* kernels, const float* biases, const float* deconvKernels);
+    int conv3x3_1to8_avx_pack(const float* kernels, float* packed);
+    int conv3x3_8to8_avx_pack(const float* kernels, float* packed);
+    int deconv2x2_8to1_avx_pack(const float* kernels, float* packed);
+    // vectorized over output channels, no horizontal sum
+    void conv3x3_1to8_avx_broadcast(const Image& src, Image& dst, const float* kernels, const float* biases);
+    void conv3x3_8to8_avx_broadcast(const Image& src, Image& dst, const float* kernels, const float* biases);
+    int conv3x3_1to8_avx_broadcast_pack(const float* kernels, float* packed);
+    int conv3x3_8to8_avx_broadcast_pack(const float* kernels, float* packed);
+    // Winograd F(2x2, 3x3), the packed kernels are transformed
+    void conv3x3_8to8_avx_winograd(const Image& src, Image& dst, const float* kernels, const float* biases);
+    int conv3x3_8to8_avx_winograd_pack(const float* kernels, float* packed);
+#   ifdef AC_CORE_WITH_F16C
+    // the feature maps are stored as Float16, the packed kernels are the same as the AVX ones
+    void conv3x3_1to8_avx_fp16(const Image& src, Image& dst, const float* kernels, const float* biases);
+    void conv3x3_8to8_avx_fp16(const Image& src, Image& dst, const float* kernels, const float* biases);
+    void deconv2x2_8to1_avx_fp16(const Image& src, Image& dst, const float* kernels);
+    void conv3x3_8to8_deconv2x2_8to1_avx_fp16(const Image& src, Image& dst, const float* kernels, const float* biases, const float* deconvKernels);
+#   endif
+    // im2col and GEMM over row strips
+    void conv3x3_1to8_avx_gemm(const Image& src, Image& dst, const float* kernels, const float* biases);
+    void conv3x3_8to8_avx_gemm(const Image& src, Image& dst, const float* kernels, const float* biases);
+#endif
+#ifdef AC_CORE_WITH_AVX2
+    // int8 weights and UInt8 feature maps, `<kernel>_quantize(kernels, biases, scaleIn, scaleOut, packed, params)` works like a pack function
+    // and also writes the requantization parameters of the layer to `params`, they are passed to the kernel instead of the biases.
+    // scaleIn and scaleOut are the scales of the input and output feature maps, a stored value v means v * scale.
+    void conv3x3_1to8_avx2_int8(const Image& src, Image& dst, const float* kernels, const float* biases);
+    void conv3x3_8to8_avx2_int8(const Image& src, Image& dst, const float* kernels, const float* biases);
+    void deconv2x2_8to1_avx2_int8(const Image& src, Image& dst, const float* kernels);
+    int conv3x3_1to8_avx2_int8_quantize(const float* kernels, const float* biases, float scaleIn, float scaleOut, float* packed, float* params);
+    int conv3x3_8to8_avx2_int8_quantize(const float* kernels, const float* biases, float scaleIn, float scaleOut, float* packed, float* params);
+    int deconv2x2_8to1_avx2_int8_quantize(const float* kernels, const float* biases, float scaleIn, float scaleOut, float* packed, float* params);
+#endif
+#ifdef AC_CORE_WITH_AVX512
+    void conv3x3_1to8_avx512(const Image& src, Image& dst, const float* kernels, const float* biases);
+    void conv3x3_8to8_avx512(const Image& src, Image& dst, const float* kernels, const float* biases);
+    void deconv2x2_8to1_avx512(const Image& src, Image& dst, const float* kernels);
+    int conv3x3_1to8_avx512_pack(const float* kernels, float* packed);
+    int conv3x3_8to8_avx512_pack(const float* kernels, float* packed);
+    int deconv2x2_8to1_avx512_pack(const float* kernels, float* packed);
 #endif
 #ifdef AC_CORE_WITH_NEON
     void conv3x3_1to8_neon(const Image& src, Image& dst, const float* kernels, const float* biases);
     void conv3x3_8to8_neon(const Image& src, Image& dst, const float* kernels, const float* biases);
     void deconv2x2_8to1_neon(const Image& src, Image& dst, const float* kernels);
+    void conv3x3_8to8_deconv2x2_8to1_neon(const Image& src, Image& dst, const float* kernels, const float* biases, const float* deconvKernels);
+#   if defined(__aarch64__) || defined(_M_ARM64)
+    // the feature maps are stored as Float16
+    void conv3x3_1to8_neon_fp16(const Image& src, Image& dst, const float* kernels, const float* biases);
+    void conv3x3_8to8_neon_fp16(const Image& src, Image& dst, const float* kernels, const float* biases);
+    void deconv2x2_8to1_neon_fp16(const Image& src, Image& dst, const float* kernels);
+    void conv3x3_8to8_deconv2x2_8to1_neon_fp16(const Image& src, Image& dst, const float* kernels, const float* biases, const float* deconvKernels);
+#   endif
 #endif
 #ifdef AC_CORE_WITH_WASM_SIMD128
     void conv3x3_1to8_wasm_simd128(const Image& src, Image& dst, const float* kernels, const float* biases);
@@ -86,6 +194,84 @@ namespace ac::core::cpu
     class CPUProcessor;
 }
 
+namespace ac::core::cpu::detail
+{
+    // fill the 1-pixel border around `image` with its edge pixels, `image` must be a roi with room for that border
+    inline static void replicateBorder(const Image& image) noexcept
+    {
+        const int w = image.width(), h = image.height();
+        const int size = image.channelSize();
+        for (int i = 0; i < h; i++)
+        {
+            std::memcpy(image.ptr(-1, i), image.ptr(0, i), size);
+            std::memcpy(image.ptr(w, i), image.ptr(w - 1, i), size);
+        }
+        std::memcpy(image.ptr(-1, -1), image.ptr(-1, 0), static_cast<std::size_t>(w + 2) * size);
+        std::memcpy(image.ptr(-1, h), image.ptr(-1, h - 1), static_cast<std::size_t>(w + 2) * size);
+    }
+    // only fuse layers when there are enough tiles to keep every thread busy
+    inline static bool tiled(const Image& src) noexcept
+    {
+        constexpr int tileSize = AC_CORE_CPU_TILE_SIZE;
+        if constexpr (tileSize > 0)
+            return ((src.width() + tileSize - 1) / tileSize) * ((src.height() + tileSize - 1) / tileSize) >= core::detail::parallelThreads();
+        else return false;
+    }
+
+    template<typename T>
+    inline static void mergeChroma(const Image& src, const Image& uv, const int ux, const int uy, const int uw, const int uh, const Image& dst, const int x, const int y) noexcept
+    {
+        const float sx = static_cast<float>(uw) / static_cast<float>(dst.width());
+        const float sy = static_cast<float>(uh) / static_cast<float>(dst.height());
+        const int channels = uv.channels();
+        for (int i = 0; i < src.height(); i++)
+        {
+            const float fy = std::clamp((static_cast<float>(y + i) + 0.5f) * sy - 0.5f, 0.0f, static_cast<float>(uh - 1));
+            const int y0 = static_cast<int>(fy), y1 = std::min(y0 + 1, uh - 1);
+            const float wy = fy - static_cast<float>(y0);
+            auto yin = static_cast<const T*>(src.ptr(i));
+            auto out = static_cast<T*>(dst.ptr(x, y + i));
+            for (int j = 0; j < src.width(); j++, out += dst.channels())
+            {
+                const float fx = std::clamp((static_cast<float>(x + j) + 0.5f) * sx - 0.5f, 0.0f, static_cast<float>(uw - 1));
+                const int x0 = static_cast<int>(fx), x1 = std::min(x0 + 1, uw - 1);
+                const float wx = fx - static_cast<float>(x0);
+                auto p00 = static_cast<const T*>(uv.ptr(x0 - ux, y0 - uy)), p01 = static_cast<const T*>(uv.ptr(x1 - ux, y0 - uy));
+                auto p10 = static_cast<const T*>(uv.ptr(x0 - ux, y1 - uy)), p11 = static_cast<const T*>(uv.ptr(x1 - ux, y1 - uy));
+                float c[3] = {};
+                for (int k = 0; k < channels; k++)
+                {
+                    float top = toFloat(p00[k]) + (toFloat(p01[k]) - toFloat(p00[k])) * wx;
+                    float bottom = toFloat(p10[k]) + (toFloat(p11[k]) - toFloat(p10[k])) * wx;
+                    // round as a resized image would be
+                    c[k] = toFloat(fromFloat<T>(top + (bottom - top) * wy));
+                }
+
+                float luma = toFloat(yin[j]);
+                float u = c[0] - 0.5f;
+                float v = c[1] - 0.5f;
+
+                out[0] = fromFloat<T>(luma + 1.403f * v);
+                out[1] = fromFloat<T>(luma - 0.344f * u - 0.714f * v);
+                out[2] = fromFloat<T>(luma + 1.773f * u);
+                if (channels == 3) out[3] = fromFloat<T>(c[2]);
+            }
+        }
+    }
+    // write the area of the RGB[A] `dst` at (x, y) covered by the luma `src`, the chroma, and alpha, are sampled bilinearly from a
+    // `uw` x `uh` image stretched to the size of `dst`, as resize does. `uv` is the part of that image starting at (ux, uy),
+    // it must cover every pixel the area samples.
+    inline static void mergeChroma(const Image& src, const Image& uv, const int ux, const int uy, const int uw, const int uh, const Image& dst, const int x, const int y) noexcept
+    {
+        switch (src.type())
+        {
+        case Image::UInt8: return mergeChroma<std::uint8_t>(src, uv, ux, uy, uw, uh, dst, x, y);
+        case Image::UInt16: return mergeChroma<std::uint16_t>(src, uv, ux, uy, uw, uh, dst, x, y);
+        case Image::Float32: return mergeChroma<float>(src, uv, ux, uy, uw, uh, dst, x, y);
+        }
+    }
+}
+
 template<>
 class ac::core::cpu::CPUProcessor<ac::core::model::ACNet> : public ac::core::Processor
 {
@@ -96,18 +282,51 @@ public:
     const char* name() const noexcept override;
 private:
     void process(const Image& src, Image& dst) override;
+    void process(const Image& src, Image& dst, Image& uv) override;
+    void processToRGB(const Image& src, const Image& uv, Image& dst) override;
+    void processLayered(const Image& src, Image& dst);
+    // if `merge`, `dst` is RGB[A] and `uv` is its chroma, or the chroma of `src` is used if it is RGB[A],
+    // otherwise `dst` is luma and the chroma of an RGB[A] `src` is stored to `uv`.
+    void processTiled(const Image& src, Image& dst, Image& uv, bool merge, int tileSize);
 private:
-    const float* kernels;
-    const float* biases;
+    // scratch slots, the layered buffers live on the calling thread and the tile buffers on each worker
+    enum
+    {
+        ScratchBuffer1 = ScratchSlotUser,
+        ScratchBuffer2,
+        ScratchTile1,
+        ScratchTile2,
+        ScratchTileLuma,
+        ScratchTileChroma,
+        ScratchTileDeconv
+    };
+
+    // kernels of each layer in the layout the arch reads, 0 is conv3x3_1to8, 1 to 8 are conv3x3_8to8 and 9 is deconv2x2_8to1
+    const float* kernels[10];
+    // biases of each conv3x3 layer, or its requantization parameters for the int8 archs
+    const float* biases[9];
+    std::unique_ptr<float[]> packed;
+    // element type of the intermediate feature maps, the computation is always in Float32
+    Image::ElementType storage;
     void (*conv3x3_1to8)(const Image& src, Image& dst, const float* kernels, const float* biases);
     void (*conv3x3_8to8)(const Image& src, Image& dst, const float* kernels, const float* biases);
     void (*deconv2x2_8to1)(const Image& src, Image& dst, const float* kernels);
+    // null if the arch has no fused kernel
+    void (*conv3x3_8to8_deconv2x2_8to1)(const Image& src, Image& dst, const float* kernels, const float* biases, const float* deconvKernels) = nullptr;
 };
 
-ac::core::cpu::CPUProcessor<ac::core::model::ACNet>::CPUProcessor(const int arch, const model::ACNet& model) noexcept : kernels(model.kernels()), biases(model.biases())
+ac::core::cpu::CPUProcessor<ac::core::model::ACNet>::CPUProcessor(const int arch, const model::ACNet& model) noexcept : storage(Image::Float32)
 {
+    // pack functions of conv3x3_1to8, conv3x3_8to8 and deconv2x2_8to1, null for the kernels reading the layout of the model
+    int (*pack[3])(const float* kernels, float* packed) = {};
+    // the int8 archs quantize the layers instead of packing them
+    int (*quantize[3])(const float* kernels, const float* biases, float scaleIn, float scaleOut, float* packed, float* params) = {};
+
     idx = (arch > arch::Begin && arch < arch::End) ? arch : []() -> int {
         // x86
+#       ifdef AC_CORE_WITH_AVX512
+            if (dispatch::supportAVX512F()) return arch::AVX512;
+#       endif
 #       ifdef AC_CORE_WITH_AVX
             if (dispatch::supportAVX()) return arch::AVX;
 #       endif
@@ -144,6 +363,18 @@ ac::core::cpu::CPUProcessor<ac::core::model::ACNet>::CPUProcessor(const int arch
         conv3x3_1to8 = conv3x3_1to8_sse;
         conv3x3_8to8 = conv3x3_8to8_sse;
         deconv2x2_8to1 = deconv2x2_8to1_sse;
+        conv3x3_8to8_deconv2x2_8to1 = conv3x3_8to8_deconv2x2_8to1_sse;
+        pack[0] = conv3x3_1to8_sse_pack;
+        pack[1] = conv3x3_8to8_sse_pack;
+        pack[2] = deconv2x2_8to1_sse_pack;
+        break;
+    case arch::SSE_BROADCAST :
+        conv3x3_1to8 = conv3x3_1to8_sse_broadcast;
+        conv3x3_8to8 = conv3x3_8to8_sse_broadcast;
+        deconv2x2_8to1 = deconv2x2_8to1_sse;
+        pack[0] = conv3x3_1to8_sse_broadcast_pack;
+        pack[1] = conv3x3_8to8_sse_broadcast_pack;
+        pack[2] = deconv2x2_8to1_sse_pack;
         break;
 #   endif
 #   ifdef AC_CORE_WITH_AVX
@@ -151,6 +382,65 @@ ac::core::cpu::CPUProcessor<ac::core::model::ACNet>::CPUProcessor(const int arch
         conv3x3_1to8 = conv3x3_1to8_avx;
         conv3x3_8to8 = conv3x3_8to8_avx;
         deconv2x2_8to1 = deconv2x2_8to1_avx;
+        conv3x3_8to8_deconv2x2_8to1 = conv3x3_8to8_deconv2x2_8to1_avx;
+        pack[0] = conv3x3_1to8_avx_pack;
+        pack[1] = conv3x3_8to8_avx_pack;
+        pack[2] = deconv2x2_8to1_avx_pack;
+        break;
+    case arch::AVX_BROADCAST :
+        conv3x3_1to8 = conv3x3_1to8_avx_broadcast;
+        conv3x3_8to8 = conv3x3_8to8_avx_broadcast;
+        deconv2x2_8to1 = deconv2x2_8to1_avx;
+        pack[0] = conv3x3_1to8_avx_broadcast_pack;
+        pack[1] = conv3x3_8to8_avx_broadcast_pack;
+        pack[2] = deconv2x2_8to1_avx_pack;
+        break;
+    case arch::AVX_WINOGRAD :
+        conv3x3_1to8 = conv3x3_1to8_avx;
+        conv3x3_8to8 = conv3x3_8to8_avx_winograd;
+        deconv2x2_8to1 = deconv2x2_8to1_avx;
+        pack[0] = conv3x3_1to8_avx_pack;
+        pack[1] = conv3x3_8to8_avx_winograd_pack;
+        pack[2] = deconv2x2_8to1_avx_pack;
+        break;
+    case arch::AVX_GEMM :
+        conv3x3_1to8 = conv3x3_1to8_avx_gemm;
+        conv3x3_8to8 = conv3x3_8to8_avx_gemm;
+        deconv2x2_8to1 = deconv2x2_8to1_avx;
+        pack[2] = deconv2x2_8to1_avx_pack;
+        break;
+#       ifdef AC_CORE_WITH_F16C
+    case arch::AVX_FP16 :
+        conv3x3_1to8 = conv3x3_1to8_avx_fp16;
+        conv3x3_8to8 = conv3x3_8to8_avx_fp16;
+        deconv2x2_8to1 = deconv2x2_8to1_avx_fp16;
+        conv3x3_8to8_deconv2x2_8to1 = conv3x3_8to8_deconv2x2_8to1_avx_fp16;
+        pack[0] = conv3x3_1to8_avx_pack;
+        pack[1] = conv3x3_8to8_avx_pack;
+        pack[2] = deconv2x2_8to1_avx_pack;
+        storage = Image::Float16;
+        break;
+#       endif
+#   endif
+#   ifdef AC_CORE_WITH_AVX2
+    case arch::AVX2_INT8 :
+        conv3x3_1to8 = conv3x3_1to8_avx2_int8;
+        conv3x3_8to8 = conv3x3_8to8_avx2_int8;
+        deconv2x2_8to1 = deconv2x2_8to1_avx2_int8;
+        quantize[0] = conv3x3_1to8_avx2_int8_quantize;
+        quantize[1] = conv3x3_8to8_avx2_int8_quantize;
+        quantize[2] = deconv2x2_8to1_avx2_int8_quantize;
+        storage = Image::UInt8;
+        break;
+#   endif
+#   ifdef AC_CORE_WITH_AVX512
+    case arch::AVX512 :
+        conv3x3_1to8 = conv3x3_1to8_avx512;
+        conv3x3_8to8 = conv3x3_8to8_avx512;
+        deconv2x2_8to1 = deconv2x2_8to1_avx512;
+        pack[0] = conv3x3_1to8_avx512_pack;
+        pack[1] = conv3x3_8to8_avx512_pack;
+        pack[2] = deconv2x2_8to1_avx512_pack;
         break;
 #   endif
 #   ifdef AC_CORE_WITH_NEON
@@ -158,7 +448,17 @@ ac::core::cpu::CPUProcessor<ac::core::model::ACNet>::CPUProcessor(const int arch
         conv3x3_1to8 = conv3x3_1to8_neon;
         conv3x3_8to8 = conv3x3_8to8_neon;
         deconv2x2_8to1 = deconv2x2_8to1_neon;
+        conv3x3_8to8_deconv2x2_8to1 = conv3x3_8to8_deconv2x2_8to1_neon;
+        break;
+#       if defined(__aarch64__) || defined(_M_ARM64)
+    case arch::NEON_FP16 :
+        conv3x3_1to8 = conv3x3_1to8_neon_fp16;
+        conv3x3_8to8 = conv3x3_8to8_neon_fp16;
+        deconv2x2_8to1 = deconv2x2_8to1_neon_fp16;
+        conv3x3_8to8_deconv2x2_8to1 = conv3x3_8to8_deconv2x2_8to1_neon_fp16;
+        storage = Image::Float16;
         break;
+#       endif
 #   endif
 #   ifdef AC_CORE_WITH_WASM_SIMD128
     case arch::WASM_SIMD128 :
@@ -171,8 +471,44 @@ ac::core::cpu::CPUProcessor<ac::core::model::ACNet>::CPUProcessor(const int arch
         conv3x3_1to8 = conv3x3_1to8_generic;
         conv3x3_8to8 = conv3x3_8to8_generic;
         deconv2x2_8to1 = deconv2x2_8to1_generic;
+        conv3x3_8to8_deconv2x2_8to1 = conv3x3_8to8_deconv2x2_8to1_generic;
         break;
     }
+
+    // all the packed layers share one buffer, each of them starts at a 64-byte boundary,
+    // the requantization parameters of a quantized layer follow its weights.
+    auto kind = [](const int l) { return l == 0 ? 0 : (l < 9 ? 1 : 2); };
+    auto size = [&](const int l) {
+        if (quantize[kind(l)]) return align(quantize[kind(l)](nullptr, nullptr, 0.0f, 0.0f, nullptr, nullptr), 16);
+        return pack[kind(l)] ? align(pack[kind(l)](nullptr, nullptr), 16) : 0;
+    };
+    // the scale of the output of conv3x3 layer l, so that its calibrated range maps to [0, 255]
+    auto scale = [&](const int l) { return model.ranges()[l] / 255.0f; };
+    int offset[11] = {};
+    for (int l = 0; l < 10; l++) offset[l + 1] = offset[l] + size(l) + (quantize[kind(l)] ? int8ParamsLength : 0);
+    float* base = nullptr;
+    if (offset[10] > 0)
+    {
+        packed = std::make_unique<float[]>(offset[10] + 15);
+        base = reinterpret_cast<float*>(align(reinterpret_cast<std::uintptr_t>(packed.get()), 64));
+    }
+    for (int l = 0; l < 10; l++)
+    {
+        kernels[l] = model.kernels() + model::ACNet::kernelOffset[l];
+        if (l < 9) biases[l] = model.biases() + model::ACNet::baisOffset[l];
+        if (quantize[kind(l)])
+        {
+            float* const params = base + offset[l] + size(l);
+            quantize[kind(l)](kernels[l], l < 9 ? biases[l] : nullptr, l > 0 ? scale(l - 1) : 1.0f, l < 9 ? scale(l) : 1.0f, base + offset[l], params);
+            kernels[l] = base + offset[l];
+            if (l < 9) biases[l] = params;
+        }
+        else if (pack[kind(l)])
+        {
+            pack[kind(l)](kernels[l], base + offset[l]);
+            kernels[l] = base + offset[l];
+        }
+    }
 }
 ac::core::cpu::CPUProcessor<ac::core::model::ACNet>::~CPUProcessor() noexcept = default;
 
@@ -182,18 +518,120 @@ const char* ac::core::cpu::CPUProcessor<ac::core::model::ACNet>::name() const no
 }
 void ac::core::cpu::CPUProcessor<ac::core::model::ACNet>::process(const Image& src, Image& dst)
 {
-    Image tmp1{src.width(), src.height(), 8, ac::core::Image::Float32};
-    Image tmp2{src.width(), src.height(), 8, ac::core::Image::Float32};
-    conv3x3_1to8(src, tmp1, kernels + model::ACNet::kernelOffset[0], biases + model::ACNet::baisOffset[0]);
-    conv3x3_8to8(tmp1, tmp2, kernels + model::ACNet::kernelOffset[1], biases + model::ACNet::baisOffset[1]);
-    conv3x3_8to8(tmp2, tmp1, kernels + model::ACNet::kernelOffset[2], biases + model::ACNet::baisOffset[2]);
-    conv3x3_8to8(tmp1, tmp2, kernels + model::ACNet::kernelOffset[3], biases + model::ACNet::baisOffset[3]);
-    conv3x3_8to8(tmp2, tmp1, kernels + model::ACNet::kernelOffset[4], biases + model::ACNet::baisOffset[4]);
-    conv3x3_8to8(tmp1, tmp2, kernels + model::ACNet::kernelOffset[5], biases + model::ACNet::baisOffset[5]);
-    conv3x3_8to8(tmp2, tmp1, kernels + model::ACNet::kernelOffset[6], biases + model::ACNet::baisOffset[6]);
-    conv3x3_8to8(tmp1, tmp2, kernels + model::ACNet::kernelOffset[7], biases + model::ACNet::baisOffset[7]);
-    conv3x3_8to8(tmp2, tmp1, kernels + model::ACNet::kernelOffset[8], biases + model::ACNet::baisOffset[8]);
-    deconv2x2_8to1(tmp1, dst, kernels + model::ACNet::kernelOffset[9]);
+    if (detail::tiled(src))
+    {
+        Image uv{};
+        return processTiled(src, dst, uv, false, AC_CORE_CPU_TILE_SIZE);
+    }
+    processLayered(src, dst);
+}
+void ac::core::cpu::CPUProcessor<ac::core::model::ACNet>::process(const Image& src, Image& dst, Image& uv)
+{
+    // the tiles convert their own part of the source, so the luma is never stored at full size
+    if (detail::tiled(src))
+    {
+        if (uv.empty()) uv.create(src.width(), src.height(), src.channels() - 1, src.type());
+        return processTiled(src, dst, uv, false, AC_CORE_CPU_TILE_SIZE);
+    }
+    Processor::process(src, dst, uv);
+}
+void ac::core::cpu::CPUProcessor<ac::core::model::ACNet>::processToRGB(const Image& src, const Image& uv, Image& dst)
+{
+    // the tiles write their RGB[A] pixels right after the deconvolution, so neither the luma nor the resized chroma is stored at full size
+    if (detail::tiled(src))
+    {
+        if (dst.empty()) dst.create(src.width() * 2, src.height() * 2, src.channels() > 1 ? src.channels() : uv.channels() + 1, src.type());
+        Image chroma{ uv };
+        return processTiled(src, dst, chroma, true, AC_CORE_CPU_TILE_SIZE);
+    }
+    Processor::processToRGB(src, uv, dst);
+}
+void ac::core::cpu::CPUProcessor<ac::core::model::ACNet>::processLayered(const Image& src, Image& dst)
+{
+    const int w = src.width(), h = src.height();
+    Image buffer1 = scratch(ScratchBuffer1, w + 2, h + 2, 8, storage);
+    Image buffer2 = scratch(ScratchBuffer2, w + 2, h + 2, 8, storage);
+    Image tmp1 = buffer1.roi(1, 1, w, h);
+    Image tmp2 = buffer2.roi(1, 1, w, h);
+    // the fused kernel runs the last conv3x3 layer, so its output is never stored
+    const int layers = conv3x3_8to8_deconv2x2_8to1 ? 8 : 9;
+    conv3x3_1to8(src, tmp1, kernels[0], biases[0]);
+    for (int l = 1; l < layers; l++)
+    {
+        detail::replicateBorder(l & 1 ? tmp1 : tmp2);
+        conv3x3_8to8(l & 1 ? tmp1 : tmp2, l & 1 ? tmp2 : tmp1, kernels[l], biases[l]);
+    }
+    if (conv3x3_8to8_deconv2x2_8to1)
+    {
+        detail::replicateBorder(tmp2);
+        conv3x3_8to8_deconv2x2_8to1(tmp2, dst, kernels[8], biases[8], kernels[9]);
+    }
+    else deconv2x2_8to1(tmp1, dst, kernels[9]);
+}
+// Run the whole network tile by tile, so the two feature maps of a tile stay in L2 cache across all layers.
+// Each conv3x3 layer computes a region one pixel smaller on each side than the previous one, so its input and the 1-pixel
+// border around it are always valid values of the previous layer. Where the region touches the edge of the image the border
+// is replicated as in processLayered, hence a halo of one pixel per conv3x3 layer gives exactly the same result.
+// An RGB[A] source is converted region by region into a tile-sized luma buffer right before the first layer reads it,
+// the chroma of the tile itself, without the halo, is copied to `uv`. When merging, the deconvolution writes a tile-sized luma
+// buffer and the RGB[A] pixels of the tile are made from it and the chroma sampled around the tile.
+void ac::core::cpu::CPUProcessor<ac::core::model::ACNet>::processTiled(const Image& src, Image& dst, Image& uv, const bool merge, const int tileSize)
+{
+    constexpr int layers = 9; // number of conv3x3 layers, also the halo size
+    constexpr int pad = layers + 1; // room for the replicated border of the first layer
+
+    const int w = src.width(), h = src.height();
+
+    parallelForTiles(w, h, tileSize, tileSize, [&](const int tx, const int ty, const int tw, const int th) {
+        // the buffers of a tile come from the scratch arena of the thread running it, so they are allocated once per thread.
+        // tmp1 starts one pixel into its buffer, so in the inner tiles every conv3x3 layer reads rows whose pixel -1 starts on 64 bytes
+        Image tmp1 = scratch(ScratchTile1, tileSize + 2 * pad + 1, tileSize + 2 * pad, 8, storage).roi(1, 0, tileSize + 2 * pad, tileSize + 2 * pad);
+        Image tmp2 = scratch(ScratchTile2, tileSize + 2 * pad, tileSize + 2 * pad, 8, storage);
+        Image luma{}, chroma{};
+        if (src.channels() > 1)
+        {
+            luma = scratch(ScratchTileLuma, tileSize + 2 * pad, tileSize + 2 * pad, 1, src.type());
+            chroma = scratch(ScratchTileChroma, tileSize + 2 * pad, tileSize + 2 * pad, src.channels() - 1, src.type());
+        }
+        Image deconv{};
+        if (merge) deconv = scratch(ScratchTileDeconv, tileSize * 2, tileSize * 2, 1, dst.type());
+        // the origin of tmp1 and tmp2 is (tx - pad, ty - pad) in source coordinates
+        auto region = [&](const Image& image, const int halo, const bool local) -> Image {
+            int x0 = std::max(tx - halo, 0), y0 = std::max(ty - halo, 0);
+            int x1 = std::min(tx + tw + halo, w), y1 = std::min(ty + th + halo, h);
+            return local ? image.roi(x0 - tx + pad, y0 - ty + pad, x1 - x0, y1 - y0) : image.roi(x0, y0, x1 - x0, y1 - y0);
+        };
+        auto in = region(src, layers, false);
+        if (src.channels() > 1)
+        {
+            auto y = region(luma, layers, true), c = region(chroma, layers, true);
+            if (src.channels() == 4) rgba2yuva(in, y, c);
+            else rgb2yuv(in, y, c);
+            if (!merge) for (int i = 0; i < th; i++) std::memcpy(uv.ptr(tx, ty + i), chroma.ptr(pad, pad + i), static_cast<std::size_t>(tw) * uv.channelSize());
+            in = y;
+        }
+        auto out = region(tmp1, layers, true);
+        conv3x3_1to8(in, out, kernels[0], biases[0]);
+        for (int l = 1; l < (conv3x3_8to8_deconv2x2_8to1 ? layers - 1 : layers); l++)
+        {
+            // the next region is one pixel smaller, so only the parts of this border outside the image are read
+            detail::replicateBorder(out);
+            in = region(l & 1 ? tmp1 : tmp2, layers - l, true);
+            out = region(l & 1 ? tmp2 : tmp1, layers - l, true);
+            conv3x3_8to8(in, out, kernels[l], biases[l]);
+        }
+        if (conv3x3_8to8_deconv2x2_8to1) detail::replicateBorder(out);
+        in = region(conv3x3_8to8_deconv2x2_8to1 ? tmp2 : tmp1, 0, true);
+        out = merge ? deconv.roi(0, 0, tw * 2, th * 2) : dst.roi(tx * 2, ty * 2, tw * 2, th * 2);
+        if (conv3x3_8to8_deconv2x2_8to1) conv3x3_8to8_deconv2x2_8to1(in, out, kernels[layers - 1], biases[layers - 1], kernels[layers]);
+        else deconv2x2_8to1(in, out, kernels[layers]);
+        if (merge)
+        {
+            // the bilinear samples of the tile reach one pixel beyond it
+            if (src.channels() > 1) detail::mergeChroma(out, region(chroma, 1, true), std::max(tx - 1, 0), std::max(ty - 1, 0), w, h, dst, tx * 2, ty * 2);
+            else detail::mergeChroma(out, uv, 0, 0, uv.width(), uv.height(), dst, tx * 2, ty * 2);
+        }
+    });
 }
 
 template<>
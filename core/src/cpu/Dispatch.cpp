@@ -13,6 +13,9 @@ namespace ac::core::cpu::dispatch::detail
         bool sse;
         bool avx;
         bool fma;
+        bool f16c;
+        bool avx2;
+        bool avx512f;
         bool neon;
     public:
         static const ISA& instance() noexcept
@@ -27,6 +30,9 @@ namespace ac::core::cpu::dispatch::detail
             sse = ruapu_supports("sse3");
             avx = ruapu_supports("avx");
             fma = ruapu_supports("fma");
+            f16c = ruapu_supports("f16c");
+            avx2 = ruapu_supports("avx2");
+            avx512f = ruapu_supports("avx512f");
             neon = ruapu_supports("neon");
         }
     };
@@ -44,6 +50,18 @@ bool ac::core::cpu::dispatch::supportFMA() noexcept
 {
     return gISA.fma;
 }
+bool ac::core::cpu::dispatch::supportF16C() noexcept
+{
+    return gISA.f16c;
+}
+bool ac::core::cpu::dispatch::supportAVX2() noexcept
+{
+    return gISA.avx2;
+}
+bool ac::core::cpu::dispatch::supportAVX512F() noexcept
+{
+    return gISA.avx512f;
+}
 bool ac::core::cpu::dispatch::supportNEON() noexcept
 {
     return gISA.neon;
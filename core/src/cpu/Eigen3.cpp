@@ -51,31 +51,30 @@ namespace ac::core::cpu
             }
         }, src, dst);
     }
+    // the 2x2 output block of each source pixel is computed from one load of its channels
     template <typename IN, typename OUT, int cin, int cout>
     inline void deconv2x2_eigen3(const Image& src, Image& dst, const float* const kernels)
     {
-        filter([=](const int i, const int j, const void* const sptr, void* const dptr) {
+        filterBlocks<2>([=](const int /*i*/, const int /*j*/, const void* const sptr, void* const* const dptrs) {
             auto in = static_cast<const IN*>(sptr);
-            auto out = static_cast<OUT*>(dptr);
-
-            const int index = ((i & 1) << 1) + (j & 1);
-
-            constexpr int nstep = 4 * cout;
 
             auto r = [&]() -> auto {
-                Eigen::Map<const Eigen::Array<IN, cin, 1>> rin{ in };
+                Eigen::Map<const Eigen::Matrix<IN, cin, 1>> rin{ in };
                 if constexpr (std::is_same_v<IN, float>)
                     return rin;
                 else if constexpr (std::is_floating_point_v<IN>)
-                    return Eigen::Array<float, cin, 1>{ rin.template cast<float>() };
+                    return Eigen::Matrix<float, cin, 1>{ rin.template cast<float>() };
                 else if constexpr (std::is_unsigned_v<IN>)
-                    return Eigen::Array<float, cin, 1>{ rin.template cast<float>() / std::numeric_limits<IN>::max() };
+                    return Eigen::Matrix<float, cin, 1>{ rin.template cast<float>() / std::numeric_limits<IN>::max() };
             }();
 
-            for (int n = 0; n < cout; n++)
+            // the kernels are [cin][4][cout], which is a column-major (4 * cout) x cin matrix
+            Eigen::Map<const Eigen::Matrix<float, 4 * cout, cin>> k(kernels);
+            const Eigen::Matrix<float, 4 * cout, 1> sums = k * r;
+            for (int index = 0; index < 4; index++)
             {
-                Eigen::Map<const Eigen::Array<float, cin, 1>, 0, Eigen::InnerStride<nstep>> k(kernels + cout * index);
-                out[n] = fromFloat<OUT>((k * r).sum());
+                auto out = static_cast<OUT*>(dptrs[index >> 1]) + (index & 1) * cout;
+                for (int n = 0; n < cout; n++) out[n] = fromFloat<OUT>(sums[index * cout + n]);
             }
         }, src, dst);
     }
@@ -53,24 +53,121 @@ namespace ac::core::cpu
             }
         }, src, dst);
     }
+    // compute `block` horizontally adjacent pixels of the row `in` per iteration, the 3x(block+2) input columns are shared by all of them,
+    // `store(j, sums)` is called with the `cout` outputs of each pixel `j` after relu
+    // the row must have a 1-pixel replicated border, so there is no clamping at the edges
+    template <int cin, int cout, int block, typename F>
+    inline void conv3x3_generic_block_row(const float* const in, const int step, const int w, const float* const kernels, const float* const biases, F&& store)
+    {
+        const float* rows[] = { in - step, in, in + step };
+
+        for (int j = 0; j < w; j += block)
+        {
+            const int valid = w - j < block ? w - j : block;
+
+            const float* r[3][block + 2];
+            for (int x = 0; x < block + 2; x++)
+            {
+                // only the last block of a row may go past the border
+                auto col = (j + x - 1 < w ? j + x - 1 : w) * cin;
+                for (int y = 0; y < 3; y++) r[y][x] = rows[y] + col;
+            }
+
+            float sums[block][cout];
+            for (int n = 0; n < cout; n++)
+            {
+                auto k0 = kernels + n * cin * 9 + cin * 0;
+                auto k1 = kernels + n * cin * 9 + cin * 1;
+                auto k2 = kernels + n * cin * 9 + cin * 2;
+                auto k3 = kernels + n * cin * 9 + cin * 3;
+                auto k4 = kernels + n * cin * 9 + cin * 4;
+                auto k5 = kernels + n * cin * 9 + cin * 5;
+                auto k6 = kernels + n * cin * 9 + cin * 6;
+                auto k7 = kernels + n * cin * 9 + cin * 7;
+                auto k8 = kernels + n * cin * 9 + cin * 8;
+
+                for (int p = 0; p < valid; p++)
+                {
+                    auto tl = r[0][p + 0], tc = r[0][p + 1], tr = r[0][p + 2];
+                    auto ml = r[1][p + 0], mc = r[1][p + 1], mr = r[1][p + 2];
+                    auto bl = r[2][p + 0], bc = r[2][p + 1], br = r[2][p + 2];
+
+                    float sum = 0.0f;
+
+                    for (int c = 0; c < cin; c++)
+                    {
+                        sum +=
+                            tl[c] * k0[c] +
+                            tc[c] * k1[c] +
+                            tr[c] * k2[c] +
+                            ml[c] * k3[c] +
+                            mc[c] * k4[c] +
+                            mr[c] * k5[c] +
+                            bl[c] * k6[c] +
+                            bc[c] * k7[c] +
+                            br[c] * k8[c];
+                    }
+                    sums[p][n] = relu<float>(sum + biases[n]);
+                }
+            }
+            for (int p = 0; p < valid; p++) store(j + p, sums[p]);
+        }
+    }
+    // src must have a 1-pixel replicated border
+    template <int cin, int cout, int block>
+    inline void conv3x3_generic_block(const Image& src, Image& dst, const float* const kernels, const float* const biases)
+    {
+        int step = src.stride() / src.elementSize();
+
+        filterRows([=](const int /*i*/, const int w, const void* const sptr, void* const dptr) {
+            auto out = static_cast<float*>(dptr);
+            conv3x3_generic_block_row<cin, cout, block>(static_cast<const float*>(sptr), step, w, kernels, biases, [=](const int j, const float* const sums) {
+                for (int n = 0; n < cout; n++) out[j * cout + n] = sums[n];
+            });
+        }, src, dst);
+    }
+    // conv3x3_generic_block followed by deconv2x2_generic with cout == 1, the 2x2 output block of each pixel is written as soon as the pixel is computed
+    // src must have a 1-pixel replicated border, dst is twice the size of src
+    template <typename OUT, int cin, int block>
+    inline void conv3x3_deconv2x2_generic(const Image& src, Image& dst, const float* const kernels, const float* const biases, const float* const deconvKernels)
+    {
+        int step = src.stride() / src.elementSize();
+
+        parallelFor(0, src.height(), [=](const int i) {
+            OUT* const out[] = { static_cast<OUT*>(dst.ptr(0, i * 2)), static_cast<OUT*>(dst.ptr(0, i * 2 + 1)) };
+            conv3x3_generic_block_row<cin, cin, block>(static_cast<const float*>(src.ptr(0, i)), step, src.width(), kernels, biases, [&](const int j, const float* const sums) {
+                for (int index = 0; index < 4; index++)
+                {
+                    float sum = 0.0f;
+                    for (int c = 0; c < cin; c++) sum += sums[c] * deconvKernels[c * 4 + index];
+                    out[index >> 1][j * 2 + (index & 1)] = fromFloat<OUT>(sum);
+                }
+            });
+        });
+    }
+    // the 2x2 output block of each source pixel is computed from one load of its channels
     template <typename IN, typename OUT, int cin, int cout>
     inline void deconv2x2_generic(const Image& src, Image& dst, const float* const kernels)
     {
-        filter([=](const int i, const int j, const void* const sptr, void* const dptr) {
+        filterBlocks<2>([=](const int /*i*/, const int /*j*/, const void* const sptr, void* const* const dptrs) {
             auto in = static_cast<const IN*>(sptr);
-            auto out = static_cast<OUT*>(dptr);
 
-            const int index = ((i & 1) << 1) + (j & 1);
-            // regarded as CHWN
-            for (int n = 0; n < cout; n++)
+            float r[cin];
+            for (int c = 0; c < cin; c++) r[c] = toFloat<IN>(in[c]);
+            for (int index = 0; index < 4; index++)
             {
-                float sum = 0.0f;
-                for (int c = 0; c < cin; c++)
+                auto out = static_cast<OUT*>(dptrs[index >> 1]) + (index & 1) * cout;
+                // regarded as CHWN
+                for (int n = 0; n < cout; n++)
                 {
-                    auto k = kernels + c * cout * 4 + cout * index;
-                    sum += toFloat<IN>(in[c]) * k[n];
+                    float sum = 0.0f;
+                    for (int c = 0; c < cin; c++)
+                    {
+                        auto k = kernels + c * cout * 4 + cout * index;
+                        sum += r[c] * k[n];
+                    }
+                    out[n] = fromFloat<OUT>(sum);
                 }
-                out[n] = fromFloat<OUT>(sum);
             }
         }, src, dst);
     }
@@ -92,7 +189,7 @@ namespace ac::core::cpu
     }
     void conv3x3_8to8_generic(const Image& src, Image& dst, const float* kernels, const float* biases)
     {
-        conv3x3_generic<float, float, 8, 8>(src, dst, kernels, biases);
+        conv3x3_generic_block<8, 8, 4>(src, dst, kernels, biases);
     }
     void deconv2x2_8to1_generic(const Image& src, Image& dst, const float* kernels)
     {
@@ -109,4 +206,19 @@ namespace ac::core::cpu
             break;
         }
     }
+    void conv3x3_8to8_deconv2x2_8to1_generic(const Image& src, Image& dst, const float* kernels, const float* biases, const float* deconvKernels)
+    {
+        switch (dst.type())
+        {
+        case Image::UInt8:
+            conv3x3_deconv2x2_generic<std::uint8_t, 8, 4>(src, dst, kernels, biases, deconvKernels);
+            break;
+        case Image::UInt16:
+            conv3x3_deconv2x2_generic<std::uint16_t, 8, 4>(src, dst, kernels, biases, deconvKernels);
+            break;
+        case Image::Float32:
+            conv3x3_deconv2x2_generic<float, 8, 4>(src, dst, kernels, biases, deconvKernels);
+            break;
+        }
+    }
 }
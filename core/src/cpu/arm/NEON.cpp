@@ -15,6 +15,41 @@ namespace ac::core::cpu
     #endif
     }
 
+    // reduce 4 vectors to one vector of their horizontal sums, [hsum(v0), hsum(v1), hsum(v2), hsum(v3)]
+    inline static float32x4_t neon_hsum4_f32(const float32x4_t* const v) noexcept
+    {
+    #if defined(__aarch64__) || defined(_M_ARM64)
+        return vpaddq_f32(vpaddq_f32(v[0], v[1]), vpaddq_f32(v[2], v[3]));
+    #else
+        float32x2_t x0 = vadd_f32(vget_low_f32(v[0]), vget_high_f32(v[0]));
+        float32x2_t x1 = vadd_f32(vget_low_f32(v[1]), vget_high_f32(v[1]));
+        float32x2_t x2 = vadd_f32(vget_low_f32(v[2]), vget_high_f32(v[2]));
+        float32x2_t x3 = vadd_f32(vget_low_f32(v[3]), vget_high_f32(v[3]));
+        return vcombine_f32(vpadd_f32(x0, x1), vpadd_f32(x2, x3));
+    #endif
+    }
+    // element type of the feature maps, halves on aarch64 where the conversion is always available
+    template <bool f16>
+    using neon_storage_t = std::conditional_t<f16, std::uint16_t, float>;
+    template <bool f16>
+    inline static float32x4_t neon_load4_f32(const neon_storage_t<f16>* const ptr) noexcept
+    {
+    #if defined(__aarch64__) || defined(_M_ARM64)
+        if constexpr (f16) return vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(ptr)));
+        else
+    #endif
+        return vld1q_f32(ptr);
+    }
+    template <bool f16>
+    inline static void neon_store4_f32(neon_storage_t<f16>* const ptr, const float32x4_t& v) noexcept
+    {
+    #if defined(__aarch64__) || defined(_M_ARM64)
+        if constexpr (f16) vst1_u16(ptr, vreinterpret_u16_f16(vcvt_f16_f32(v)));
+        else
+    #endif
+        vst1q_f32(ptr, v);
+    }
+
     template <typename OUT, int cin, int cout>
     inline void conv3x3_neon_float(const Image& src, Image& dst, const float* const kernels, const float* const biases)
     {
@@ -165,15 +200,89 @@ namespace ac::core::cpu
             }
         }, src, dst);
     }
-    template <typename IN, typename OUT, int cout>
+    // compute `block` horizontally adjacent pixels of the row `in` per iteration, the 3x(block+2) input columns are loaded once and shared by all of them,
+    // `store(j, v)` is called with the `cout / 4` vectors of outputs of each pixel `j` after relu
+    // the row must have a 1-pixel replicated border, so there is no clamping at the edges
+    // the row is stored as halves if f16
+    template <bool f16, int cin, int cout, int block, typename F>
+    inline void conv3x3_neon_block_row(const neon_storage_t<f16>* const in, const int step, const int w, const float* const kernels, const float* const biases, F&& store)
+    {
+        constexpr int vstep = 4;
+        constexpr int count = cin / vstep;
+        static_assert(cin % vstep == 0 && cout % vstep == 0, "cin and cout must be multiples of 4");
+
+        const neon_storage_t<f16>* rows[] = { in - step, in, in + step };
+
+        for (int j = 0; j < w; j += block)
+        {
+            const int valid = w - j < block ? w - j : block;
+
+            float32x4_t r[3][block + 2][count];
+            for (int x = 0; x < block + 2; x++)
+            {
+                // only the last block of a row may go past the border
+                auto col = (j + x - 1 < w ? j + x - 1 : w) * cin;
+                for (int y = 0; y < 3; y++)
+                    for (int idx = 0; idx < count; idx++) r[y][x][idx] = neon_load4_f32<f16>(rows[y] + col + idx * vstep);
+            }
+
+            for (int p = 0; p < valid; p++)
+            {
+                float32x4_t v[cout / vstep];
+                for (int m = 0; m < cout; m += vstep)
+                {
+                    float32x4_t sum[vstep];
+                    for (int n = 0; n < vstep; n++)
+                    {
+                        float32x4_t s0 = vdupq_n_f32(0.0f);
+                        float32x4_t s1 = vdupq_n_f32(0.0f);
+                        float32x4_t s2 = vdupq_n_f32(0.0f);
+                        for (int idx = 0; idx < count; idx++)
+                        {
+                            const float* kptr = kernels + (m + n) * cin * 9 + idx * vstep;
+                            s0 = vmlaq_f32(s0, r[0][p + 0][idx], vld1q_f32(kptr + cin * 0));
+                            s1 = vmlaq_f32(s1, r[0][p + 1][idx], vld1q_f32(kptr + cin * 1));
+                            s2 = vmlaq_f32(s2, r[0][p + 2][idx], vld1q_f32(kptr + cin * 2));
+                            s0 = vmlaq_f32(s0, r[1][p + 0][idx], vld1q_f32(kptr + cin * 3));
+                            s1 = vmlaq_f32(s1, r[1][p + 1][idx], vld1q_f32(kptr + cin * 4));
+                            s2 = vmlaq_f32(s2, r[1][p + 2][idx], vld1q_f32(kptr + cin * 5));
+                            s0 = vmlaq_f32(s0, r[2][p + 0][idx], vld1q_f32(kptr + cin * 6));
+                            s1 = vmlaq_f32(s1, r[2][p + 1][idx], vld1q_f32(kptr + cin * 7));
+                            s2 = vmlaq_f32(s2, r[2][p + 2][idx], vld1q_f32(kptr + cin * 8));
+                        }
+                        sum[n] = vaddq_f32(s0, vaddq_f32(s1, s2));
+                    }
+                    v[m / vstep] = vmaxq_f32(vaddq_f32(neon_hsum4_f32(sum), vld1q_f32(biases + m)), vdupq_n_f32(0.0f));
+                }
+                store(j + p, v);
+            }
+        }
+    }
+    // src must have a 1-pixel replicated border, src and dst are stored as halves if f16
+    template <bool f16, int cin, int cout, int block>
+    inline void conv3x3_neon_block(const Image& src, Image& dst, const float* const kernels, const float* const biases)
+    {
+        int step = src.stride() / src.elementSize();
+
+        filterRows([=](const int /*i*/, const int w, const void* const sptr, void* const dptr) {
+            auto out = static_cast<neon_storage_t<f16>*>(dptr);
+            conv3x3_neon_block_row<f16, cin, cout, block>(static_cast<const neon_storage_t<f16>*>(sptr), step, w, kernels, biases, [=](const int j, const float32x4_t* const v) {
+                for (int m = 0; m < cout; m += 4) neon_store4_f32<f16>(out + j * cout + m, v[m / 4]);
+            });
+        }, src, dst);
+    }
+    // dst is stored as halves if f16
+    template <typename IN, bool f16, int cout>
     inline void conv3x3_neon_cin1(const Image& src, Image& dst, const float* const kernels, const float* const biases)
     {
+        static_assert(cout % 4 == 0, "cout must be a multiple of 4");
+
         int w = src.width(), h = src.height();
         int step = src.stride() / src.elementSize();
 
         filter([=](const int i, const int j, const void* const sptr, void* const dptr) {
             auto in = static_cast<const IN*>(sptr);
-            auto out = static_cast<OUT*>(dptr);
+            auto out = static_cast<neon_storage_t<f16>*>(dptr);
 
             auto sp = i < h - 1 ? +step : 0;
             auto sn = i > 0 ? -step : 0;
@@ -191,24 +300,26 @@ namespace ac::core::cpu
             float32x4_t r0 = vld1q_f32(d0);
             float32x4_t r4 = vld1q_f32(d4);
 
+            float sums[cout];
             for (int n = 0; n < cout; n++)
             {
                 float32x4_t k0 = vld1q_f32(kernels + n * 9 + 0);
                 float32x4_t k4 = vld1q_f32(kernels + n * 9 + 4);
                 auto sum = neon_hsum_f32(vmlaq_f32(vmulq_f32(r0, k0), r4, k4));
                 auto k8 = *(kernels + n * 9 + 8);
-                out[n] = relu<OUT>(sum + k8 * r8 + biases[n]);
+                sums[n] = sum + k8 * r8 + biases[n];
             }
+            for (int m = 0; m < cout; m += 4) neon_store4_f32<f16>(out + m, vmaxq_f32(vld1q_f32(sums + m), vdupq_n_f32(0.0f)));
         }, src, dst);
     }
-    template <typename OUT, int cin, int cout>
+    // the 2x2 output block of each source pixel is computed from one load of its channels, src is stored as halves if f16
+    template <typename OUT, bool f16, int cin, int cout>
     inline void deconv2x2_neon_float(const Image& src, Image& dst, const float* const kernels)
     {
-        filter([=](const int i, const int j, const void* const sptr, void* const dptr) {
-            auto in = static_cast<const float*>(sptr);
-            auto out = static_cast<OUT*>(dptr);
+        static_assert(!f16 || cin % 4 == 0, "cin must be a multiple of 4 for halves");
 
-            const int index = ((i & 1) << 1) + (j & 1);
+        filterBlocks<2>([=](const int /*i*/, const int /*j*/, const void* const sptr, void* const* const dptrs) {
+            auto in = static_cast<const neon_storage_t<f16>*>(sptr);
 
             constexpr int vstep = 4;
             constexpr int count = cin / vstep;
@@ -216,34 +327,81 @@ namespace ac::core::cpu
             constexpr int nstep = 4 * cout;
 
             float32x4_t  r[count + (remain ? 1 : 0)] = {};
-            for (int idx = 0; idx < count; idx++) r[idx] = vld1q_f32(in + idx * vstep);
+            for (int idx = 0; idx < count; idx++) r[idx] = neon_load4_f32<f16>(in + idx * vstep);
 
             if constexpr (remain)
             {
                 const float d[vstep] = {(in + count * vstep)[0], remain > 1 ? (in + count * vstep)[1] : 0.0f, remain > 2 ? (in + count * vstep)[2] : 0.0f, 0.0f};
                 r[count] = vld1q_f32(d);
             }
-            for (int n = 0; n < cout; n++)
+            for (int index = 0; index < 4; index++)
             {
-                float sum = 0.0f;
-                float32x4_t k[count + (remain ? 1 : 0)] = {};
+                auto out = static_cast<OUT*>(dptrs[index >> 1]) + (index & 1) * cout;
+                for (int n = 0; n < cout; n++)
+                {
+                    float sum = 0.0f;
+                    float32x4_t k[count + (remain ? 1 : 0)] = {};
+                    for (int idx = 0; idx < count; idx++)
+                    {
+                        auto kptr = kernels + idx * vstep * cout * 4 + cout * index;
+                        const float d[vstep] = {kptr[0 * nstep + n], kptr[1 * nstep + n], kptr[2 * nstep + n], kptr[3 * nstep + n]};
+                        k[idx] = vld1q_f32(d);
+                        sum += neon_hsum_f32(vmulq_f32(r[idx], k[idx]));
+                    }
+                    if constexpr (remain)
+                    {
+                        auto kptr = kernels + count * vstep * cout * 4 + cout * index;
+                        const float d[vstep] = {kptr[0 * nstep + n], remain > 1 ? kptr[1 * nstep + n] : 0.0f, remain > 2 ? kptr[2 * nstep + n] : 0.0f, 0.0f};
+                        k[count] = vld1q_f32(d);
+                        sum += neon_hsum_f32(vmulq_f32(r[count], k[count]));
+                    }
+                    out[n] = fromFloat<OUT>(sum);
+                }
+            }
+        }, src, dst);
+    }
+    // conv3x3_neon_block followed by deconv2x2_neon_float with cout == 1, the 2x2 output block of each pixel is written as soon as the pixel is computed
+    // src must have a 1-pixel replicated border and is stored as halves if f16, dst is twice the size of src
+    template <typename OUT, bool f16, int cin, int block>
+    inline void conv3x3_deconv2x2_neon(const Image& src, Image& dst, const float* const kernels, const float* const biases, const float* const deconvKernels)
+    {
+        constexpr int vstep = 4;
+        constexpr int count = cin / vstep;
+        static_assert(cin % vstep == 0, "cin must be a multiple of 4");
+
+        // the deconvolution kernels of each output position, gathered to vectors over the input channels
+        float32x4_t k[4][count];
+        for (int index = 0; index < 4; index++)
+            for (int idx = 0; idx < count; idx++)
+            {
+                auto kptr = deconvKernels + idx * vstep * 4 + index;
+                const float d[vstep] = {kptr[0], kptr[4], kptr[8], kptr[12]};
+                k[index][idx] = vld1q_f32(d);
+            }
+
+        int step = src.stride() / src.elementSize();
+
+        parallelFor(0, src.height(), [&](const int i) {
+            OUT* const out[] = { static_cast<OUT*>(dst.ptr(0, i * 2)), static_cast<OUT*>(dst.ptr(0, i * 2 + 1)) };
+            conv3x3_neon_block_row<f16, cin, cin, block>(static_cast<const neon_storage_t<f16>*>(src.ptr(0, i)), step, src.width(), kernels, biases, [&](const int j, const float32x4_t* const v) {
+                float32x4_t r[count];
                 for (int idx = 0; idx < count; idx++)
                 {
-                    auto kptr = kernels + idx * vstep * cout * 4 + cout * index;
-                    const float d[vstep] = {kptr[0 * nstep + n], kptr[1 * nstep + n], kptr[2 * nstep + n], kptr[3 * nstep + n]};
-                    k[idx] = vld1q_f32(d);
-                    sum += neon_hsum_f32(vmulq_f32(r[idx], k[idx]));
+                    // round as the stored feature map would be
+                #if defined(__aarch64__) || defined(_M_ARM64)
+                    if constexpr (f16) r[idx] = vcvt_f32_f16(vcvt_f16_f32(v[idx]));
+                    else
+                #endif
+                    r[idx] = v[idx];
                 }
-                if constexpr (remain)
+                for (int index = 0; index < 4; index++)
                 {
-                    auto kptr = kernels + count * vstep * cout * 4 + cout * index;
-                    const float d[vstep] = {kptr[0 * nstep + n], remain > 1 ? kptr[1 * nstep + n] : 0.0f, remain > 2 ? kptr[2 * nstep + n] : 0.0f, 0.0f};
-                    k[count] = vld1q_f32(d);
-                    sum += neon_hsum_f32(vmulq_f32(r[count], k[count]));
+                    float sum = 0.0f;
+                    for (int idx = 0; idx < count; idx++) sum += neon_hsum_f32(vmulq_f32(r[idx], k[index][idx]));
+                    out[index >> 1][j * 2 + (index & 1)] = fromFloat<OUT>(sum);
                 }
-                out[n] = fromFloat<OUT>(sum);
-            }
-        }, src, dst);
+            });
+        });
     }
 
     void conv3x3_1to8_neon(const Image& src, Image& dst, const float* kernels, const float* biases)
@@ -251,33 +409,99 @@ namespace ac::core::cpu
         switch (src.type())
         {
         case Image::UInt8:
-            conv3x3_neon_cin1<std::uint8_t, float, 8>(src, dst, kernels, biases);
+            conv3x3_neon_cin1<std::uint8_t, false, 8>(src, dst, kernels, biases);
             break;
         case Image::UInt16:
-            conv3x3_neon_cin1<std::uint16_t, float, 8>(src, dst, kernels, biases);
+            conv3x3_neon_cin1<std::uint16_t, false, 8>(src, dst, kernels, biases);
             break;
         case Image::Float32:
-            conv3x3_neon_cin1<float, float, 8>(src, dst, kernels, biases);
+            conv3x3_neon_cin1<float, false, 8>(src, dst, kernels, biases);
             break;
         }
     }
     void conv3x3_8to8_neon(const Image& src, Image& dst, const float* kernels, const float* biases)
     {
-        conv3x3_neon_float<float, 8, 8>(src, dst, kernels, biases);
+        conv3x3_neon_block<false, 8, 8, 4>(src, dst, kernels, biases);
     }
     void deconv2x2_8to1_neon(const Image& src, Image& dst, const float* kernels)
     {
         switch (dst.type())
         {
         case Image::UInt8:
-            deconv2x2_neon_float<std::uint8_t, 8, 1>(src, dst, kernels);
+            deconv2x2_neon_float<std::uint8_t, false, 8, 1>(src, dst, kernels);
+            break;
+        case Image::UInt16:
+            deconv2x2_neon_float<std::uint16_t, false, 8, 1>(src, dst, kernels);
+            break;
+        case Image::Float32:
+            deconv2x2_neon_float<float, false, 8, 1>(src, dst, kernels);
+            break;
+        }
+    }
+    void conv3x3_8to8_deconv2x2_8to1_neon(const Image& src, Image& dst, const float* kernels, const float* biases, const float* deconvKernels)
+    {
+        switch (dst.type())
+        {
+        case Image::UInt8:
+            conv3x3_deconv2x2_neon<std::uint8_t, false, 8, 4>(src, dst, kernels, biases, deconvKernels);
+            break;
+        case Image::UInt16:
+            conv3x3_deconv2x2_neon<std::uint16_t, false, 8, 4>(src, dst, kernels, biases, deconvKernels);
+            break;
+        case Image::Float32:
+            conv3x3_deconv2x2_neon<float, false, 8, 4>(src, dst, kernels, biases, deconvKernels);
+            break;
+        }
+    }
+#if defined(__aarch64__) || defined(_M_ARM64)
+    void conv3x3_1to8_neon_fp16(const Image& src, Image& dst, const float* kernels, const float* biases)
+    {
+        switch (src.type())
+        {
+        case Image::UInt8:
+            conv3x3_neon_cin1<std::uint8_t, true, 8>(src, dst, kernels, biases);
+            break;
+        case Image::UInt16:
+            conv3x3_neon_cin1<std::uint16_t, true, 8>(src, dst, kernels, biases);
+            break;
+        case Image::Float32:
+            conv3x3_neon_cin1<float, true, 8>(src, dst, kernels, biases);
+            break;
+        }
+    }
+    void conv3x3_8to8_neon_fp16(const Image& src, Image& dst, const float* kernels, const float* biases)
+    {
+        conv3x3_neon_block<true, 8, 8, 4>(src, dst, kernels, biases);
+    }
+    void deconv2x2_8to1_neon_fp16(const Image& src, Image& dst, const float* kernels)
+    {
+        switch (dst.type())
+        {
+        case Image::UInt8:
+            deconv2x2_neon_float<std::uint8_t, true, 8, 1>(src, dst, kernels);
+            break;
+        case Image::UInt16:
+            deconv2x2_neon_float<std::uint16_t, true, 8, 1>(src, dst, kernels);
+            break;
+        case Image::Float32:
+            deconv2x2_neon_float<float, true, 8, 1>(src, dst, kernels);
+            break;
+        }
+    }
+    void conv3x3_8to8_deconv2x2_8to1_neon_fp16(const Image& src, Image& dst, const float* kernels, const float* biases, const float* deconvKernels)
+    {
+        switch (dst.type())
+        {
+        case Image::UInt8:
+            conv3x3_deconv2x2_neon<std::uint8_t, true, 8, 4>(src, dst, kernels, biases, deconvKernels);
             break;
         case Image::UInt16:
-            deconv2x2_neon_float<std::uint16_t, 8, 1>(src, dst, kernels);
+            conv3x3_deconv2x2_neon<std::uint16_t, true, 8, 4>(src, dst, kernels, biases, deconvKernels);
             break;
         case Image::Float32:
-            deconv2x2_neon_float<float, 8, 1>(src, dst, kernels);
+            conv3x3_deconv2x2_neon<float, true, 8, 4>(src, dst, kernels, biases, deconvKernels);
             break;
         }
     }
+#endif
 }
@@ -12,6 +12,14 @@ namespace ac::core::cpu
         return wasm_f32x4_extract_lane(v32, 0);
     }
 
+    // reduce 4 vectors to one vector of their horizontal sums, [hsum(v0), hsum(v1), hsum(v2), hsum(v3)]
+    inline static v128_t wasm_simd128_f32x4_hsum4(const v128_t* const v) noexcept
+    {
+        v128_t v01 = wasm_f32x4_add(wasm_i32x4_shuffle(v[0], v[1], 0, 4, 1, 5), wasm_i32x4_shuffle(v[0], v[1], 2, 6, 3, 7));
+        v128_t v23 = wasm_f32x4_add(wasm_i32x4_shuffle(v[2], v[3], 0, 4, 1, 5), wasm_i32x4_shuffle(v[2], v[3], 2, 6, 3, 7));
+        return wasm_f32x4_add(wasm_i32x4_shuffle(v01, v23, 0, 1, 4, 5), wasm_i32x4_shuffle(v01, v23, 2, 3, 6, 7));
+    }
+
     template <typename OUT, int cin, int cout>
     inline void conv3x3_wasm_simd128_float(const Image& src, Image& dst, const float* const kernels, const float* const biases)
     {
@@ -136,6 +144,67 @@ namespace ac::core::cpu
             }
         }, src, dst);
     }
+    // compute `block` horizontally adjacent pixels per iteration, the 3x(block+2) input columns are loaded once and shared by all of them
+    // src must have a 1-pixel replicated border, so there is no clamping at the edges
+    template <int cin, int cout, int block>
+    inline void conv3x3_wasm_simd128_block(const Image& src, Image& dst, const float* const kernels, const float* const biases)
+    {
+        constexpr int vstep = 4;
+        constexpr int count = cin / vstep;
+        static_assert(cin % vstep == 0 && cout % vstep == 0, "cin and cout must be multiples of 4");
+
+        int step = src.stride() / src.elementSize();
+
+        filterRows([=](const int /*i*/, const int w, const void* const sptr, void* const dptr) {
+            auto in = static_cast<const float*>(sptr);
+            auto out = static_cast<float*>(dptr);
+
+            const float* rows[] = { in - step, in, in + step };
+
+            for (int j = 0; j < w; j += block)
+            {
+                const int valid = w - j < block ? w - j : block;
+
+                v128_t r[3][block + 2][count];
+                for (int x = 0; x < block + 2; x++)
+                {
+                    // only the last block of a row may go past the border
+                    auto col = (j + x - 1 < w ? j + x - 1 : w) * cin;
+                    for (int y = 0; y < 3; y++)
+                        for (int idx = 0; idx < count; idx++) r[y][x][idx] = wasm_v128_load(rows[y] + col + idx * vstep);
+                }
+
+                for (int p = 0; p < valid; p++)
+                {
+                    for (int m = 0; m < cout; m += vstep)
+                    {
+                        v128_t sum[vstep];
+                        for (int n = 0; n < vstep; n++)
+                        {
+                            v128_t s0 = wasm_f32x4_splat(0.0f);
+                            v128_t s1 = wasm_f32x4_splat(0.0f);
+                            v128_t s2 = wasm_f32x4_splat(0.0f);
+                            for (int idx = 0; idx < count; idx++)
+                            {
+                                const float* kptr = kernels + (m + n) * cin * 9 + idx * vstep;
+                                s0 = wasm_f32x4_add(s0, wasm_f32x4_mul(r[0][p + 0][idx], wasm_v128_load(kptr + cin * 0)));
+                                s1 = wasm_f32x4_add(s1, wasm_f32x4_mul(r[0][p + 1][idx], wasm_v128_load(kptr + cin * 1)));
+                                s2 = wasm_f32x4_add(s2, wasm_f32x4_mul(r[0][p + 2][idx], wasm_v128_load(kptr + cin * 2)));
+                                s0 = wasm_f32x4_add(s0, wasm_f32x4_mul(r[1][p + 0][idx], wasm_v128_load(kptr + cin * 3)));
+                                s1 = wasm_f32x4_add(s1, wasm_f32x4_mul(r[1][p + 1][idx], wasm_v128_load(kptr + cin * 4)));
+                                s2 = wasm_f32x4_add(s2, wasm_f32x4_mul(r[1][p + 2][idx], wasm_v128_load(kptr + cin * 5)));
+                                s0 = wasm_f32x4_add(s0, wasm_f32x4_mul(r[2][p + 0][idx], wasm_v128_load(kptr + cin * 6)));
+                                s1 = wasm_f32x4_add(s1, wasm_f32x4_mul(r[2][p + 1][idx], wasm_v128_load(kptr + cin * 7)));
+                                s2 = wasm_f32x4_add(s2, wasm_f32x4_mul(r[2][p + 2][idx], wasm_v128_load(kptr + cin * 8)));
+                            }
+                            sum[n] = wasm_f32x4_add(s0, wasm_f32x4_add(s1, s2));
+                        }
+                        wasm_v128_store(out + (j + p) * cout + m, wasm_f32x4_max(wasm_f32x4_add(wasm_simd128_f32x4_hsum4(sum), wasm_v128_load(biases + m)), wasm_f32x4_splat(0.0f)));
+                    }
+                }
+            }
+        }, src, dst);
+    }
     template <typename IN, typename OUT, int cout>
     inline void conv3x3_wasm_simd128_cin1(const Image& src, Image& dst, const float* const kernels, const float* const biases)
     {
@@ -169,14 +238,12 @@ namespace ac::core::cpu
             }
         }, src, dst);
     }
+    // the 2x2 output block of each source pixel is computed from one load of its channels
     template <typename OUT, int cin, int cout>
     inline void deconv2x2_wasm_simd128_float(const Image& src, Image& dst, const float* const kernels)
     {
-        filter([=](const int i, const int j, const void* const sptr, void* const dptr) {
+        filterBlocks<2>([=](const int /*i*/, const int /*j*/, const void* const sptr, void* const* const dptrs) {
             auto in = static_cast<const float*>(sptr);
-            auto out = static_cast<OUT*>(dptr);
-
-            const int index = ((i & 1) << 1) + (j & 1);
 
             constexpr int vstep = 4;
             constexpr int count = cin / vstep;
@@ -187,23 +254,27 @@ namespace ac::core::cpu
             for (int idx = 0; idx < count; idx++) r[idx] = wasm_v128_load(in + idx * vstep);
 
             if constexpr (remain) r[count] = wasm_f32x4_make((in + count * vstep)[0], remain > 1 ? (in + count * vstep)[1] : 0.0f, remain > 2 ? (in + count * vstep)[2] : 0.0f, 0.0f);
-            for (int n = 0; n < cout; n++)
+            for (int index = 0; index < 4; index++)
             {
-                float sum = 0.0f;
-                v128_t k[count + (remain ? 1 : 0)] = {};
-                for (int idx = 0; idx < count; idx++)
-                {
-                    auto kptr = kernels + idx * vstep * cout * 4 + cout * index;
-                    k[idx] = wasm_f32x4_make(kptr[0 * nstep + n], kptr[1 * nstep + n], kptr[2 * nstep + n], kptr[3 * nstep + n]);
-                    sum += wasm_simd128_f32x4_hsum(wasm_f32x4_mul(r[idx], k[idx]));
-                }
-                if constexpr (remain)
+                auto out = static_cast<OUT*>(dptrs[index >> 1]) + (index & 1) * cout;
+                for (int n = 0; n < cout; n++)
                 {
-                    auto kptr = kernels + count * vstep * cout * 4 + cout * index;
-                    k[count] = wasm_f32x4_make(kptr[0 * nstep + n], remain > 1 ? kptr[1 * nstep + n] : 0.0f, remain > 2 ? kptr[2 * nstep + n] : 0.0f, 0.0f);
-                    sum += wasm_simd128_f32x4_hsum(wasm_f32x4_mul(r[count], k[count]));
+                    float sum = 0.0f;
+                    v128_t k[count + (remain ? 1 : 0)] = {};
+                    for (int idx = 0; idx < count; idx++)
+                    {
+                        auto kptr = kernels + idx * vstep * cout * 4 + cout * index;
+                        k[idx] = wasm_f32x4_make(kptr[0 * nstep + n], kptr[1 * nstep + n], kptr[2 * nstep + n], kptr[3 * nstep + n]);
+                        sum += wasm_simd128_f32x4_hsum(wasm_f32x4_mul(r[idx], k[idx]));
+                    }
+                    if constexpr (remain)
+                    {
+                        auto kptr = kernels + count * vstep * cout * 4 + cout * index;
+                        k[count] = wasm_f32x4_make(kptr[0 * nstep + n], remain > 1 ? kptr[1 * nstep + n] : 0.0f, remain > 2 ? kptr[2 * nstep + n] : 0.0f, 0.0f);
+                        sum += wasm_simd128_f32x4_hsum(wasm_f32x4_mul(r[count], k[count]));
+                    }
+                    out[n] = fromFloat<OUT>(sum);
                 }
-                out[n] = fromFloat<OUT>(sum);
             }
         }, src, dst);
     }
@@ -225,7 +296,7 @@ namespace ac::core::cpu
     }
     void conv3x3_8to8_wasm_simd128(const Image& src, Image& dst, const float* kernels, const float* biases)
     {
-        conv3x3_wasm_simd128_float<float, 8, 8>(src, dst, kernels, biases);
+        conv3x3_wasm_simd128_block<8, 8, 4>(src, dst, kernels, biases);
     }
     void deconv2x2_8to1_wasm_simd128(const Image& src, Image& dst, const float* kernels)
     {
@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
 #include <immintrin.h>
 
 #include "AC/Core/Dispatch.hpp"
@@ -13,6 +17,80 @@ namespace ac::core::cpu
         __m128 v32 = _mm_add_ss(v64, _mm_movehdup_ps(v64));
         return _mm_cvtss_f32(v32);
     }
+    template <bool fma>
+    inline static __m256 avx_madd_ps(const __m256& a, const __m256& b, const __m256& c) noexcept
+    {
+#   ifdef AC_CORE_WITH_FMA
+        if constexpr (fma) return _mm256_fmadd_ps(a, b, c);
+        else
+#   endif
+        return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+    }
+    // element type of the feature maps, halves with f16c
+    template <bool f16>
+    using avx_storage_t = std::conditional_t<f16, std::uint16_t, float>;
+    template <bool f16>
+    inline static __m256 avx_load8_ps(const avx_storage_t<f16>* const ptr) noexcept
+    {
+#   ifdef AC_CORE_WITH_F16C
+        if constexpr (f16) return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr)));
+        else
+#   endif
+        return _mm256_loadu_ps(ptr);
+    }
+    template <bool f16>
+    inline static void avx_store8_ps(avx_storage_t<f16>* const ptr, const __m256& v) noexcept
+    {
+#   ifdef AC_CORE_WITH_F16C
+        if constexpr (f16) _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+        else
+#   endif
+        _mm256_storeu_ps(ptr, v);
+    }
+    // copy `size` bytes from the 32-byte aligned `src` to `dst`, its 32-byte chunks are written with non-temporal stores if `nt` and `dst` is 32-byte aligned,
+    // a _mm_sfence is needed before they are read by another thread.
+    inline static void avx_stream(void* const dst, const void* const src, const int size, const bool nt) noexcept
+    {
+        if (nt && !(reinterpret_cast<std::uintptr_t>(dst) & 31))
+        {
+            auto d = static_cast<float*>(dst);
+            auto s = static_cast<const float*>(src);
+            int i = 0;
+            for (; i + 32 <= size; i += 32) _mm256_stream_ps(d + i / 4, _mm256_load_ps(s + i / 4));
+            if (i < size) std::memcpy(d + i / 4, s + i / 4, size - i);
+        }
+        else std::memcpy(dst, src, size);
+    }
+    // write the 2x2 output blocks of `n` source pixels starting at `j` of a row, `buffer` holds the two output rows of them
+    template <typename OUT, int size>
+    inline static void avx_store_blocks(OUT* const* const out, const OUT (&buffer)[2][size], const int j, const int n, const int cout, const bool nt) noexcept
+    {
+        for (int k = 0; k < 2; k++) avx_stream(out[k] + j * 2 * cout, buffer[k], static_cast<int>(n * 2 * cout * sizeof(OUT)), nt);
+    }
+    // transpose conv3x3 kernels from [cout][9][cin] to [9][cin][cout], so that all the output channels of one input value are contiguous
+    template <int cin, int cout>
+    inline static void avx_broadcast_pack(const float* const kernels, float* const packed) noexcept
+    {
+        for (int n = 0; n < cout; n++)
+            for (int k = 0; k < 9 * cin; k++)
+                packed[k * cout + n] = kernels[n * cin * 9 + k];
+    }
+    // pad the 9 taps of each output channel of a cin == 1 conv3x3 to 16, so that the first 8 of them are one aligned vector
+    template <int cout>
+    inline static void avx_cin1_pack(const float* const kernels, float* const packed) noexcept
+    {
+        for (int n = 0; n < cout; n++)
+            for (int k = 0; k < 16; k++) packed[n * 16 + k] = k < 9 ? kernels[n * 9 + k] : 0.0f;
+    }
+    // transpose deconv2x2 kernels from [cin][4][cout] to [4][cout][cin], cin padded to a multiple of 8 with zeros
+    template <int cin, int cout>
+    inline static void avx_deconv2x2_pack(const float* const kernels, float* const packed) noexcept
+    {
+        constexpr int cinp = align(cin, 8);
+        for (int index = 0; index < 4; index++)
+            for (int n = 0; n < cout; n++)
+                for (int c = 0; c < cinp; c++) packed[(index * cout + n) * cinp + c] = c < cin ? kernels[c * cout * 4 + cout * index + n] : 0.0f;
+    }
 
     template <typename OUT, int cin, int cout>
     inline void conv3x3_avx_fma_float(const Image& src, Image& dst, const float* const kernels, const float* const biases)
@@ -270,15 +348,96 @@ namespace ac::core::cpu
             }
         }, src, dst);
     }
-    template <typename IN, typename OUT, int cout>
+    // reduce 8 vectors to one vector of their horizontal sums, [hsum(v0), hsum(v1), ..., hsum(v7)]
+    inline static __m256 avx_hsum8_ps(const __m256* const v) noexcept
+    {
+        __m256 t0 = _mm256_hadd_ps(_mm256_hadd_ps(v[0], v[1]), _mm256_hadd_ps(v[2], v[3]));
+        __m256 t1 = _mm256_hadd_ps(_mm256_hadd_ps(v[4], v[5]), _mm256_hadd_ps(v[6], v[7]));
+        return _mm256_add_ps(_mm256_permute2f128_ps(t0, t1, 0x20), _mm256_permute2f128_ps(t0, t1, 0x31));
+    }
+    // compute `block` horizontally adjacent pixels of the row `in` per iteration, the 3x(block+2) input columns are loaded once and shared by all of them,
+    // `store(j, v)` is called with the `cout / 8` vectors of outputs of each pixel `j` after relu
+    // the row must have a 1-pixel replicated border, so there is no clamping at the edges
+    // kernels must be 32-byte aligned, the row is stored as halves if f16
+    template <bool fma, bool f16, int cin, int cout, int block, typename F>
+    inline void conv3x3_avx_block_row(const avx_storage_t<f16>* const in, const int step, const int w, const float* const kernels, const float* const biases, F&& store)
+    {
+        constexpr int vstep = 8;
+        constexpr int count = cin / vstep;
+        static_assert(cin % vstep == 0 && cout % vstep == 0, "cin and cout must be multiples of 8");
+
+        const avx_storage_t<f16>* rows[] = { in - step, in, in + step };
+
+        for (int j = 0; j < w; j += block)
+        {
+            const int valid = w - j < block ? w - j : block;
+
+            __m256 r[3][block + 2][count];
+            for (int x = 0; x < block + 2; x++)
+            {
+                // only the last block of a row may go past the border
+                auto col = (j + x - 1 < w ? j + x - 1 : w) * cin;
+                for (int y = 0; y < 3; y++)
+                    for (int idx = 0; idx < count; idx++) r[y][x][idx] = avx_load8_ps<f16>(rows[y] + col + idx * vstep);
+            }
+
+            for (int p = 0; p < valid; p++)
+            {
+                __m256 v[cout / vstep];
+                for (int m = 0; m < cout; m += vstep)
+                {
+                    __m256 sum[vstep];
+                    for (int n = 0; n < vstep; n++)
+                    {
+                        __m256 s0 = _mm256_setzero_ps();
+                        __m256 s1 = _mm256_setzero_ps();
+                        __m256 s2 = _mm256_setzero_ps();
+                        for (int idx = 0; idx < count; idx++)
+                        {
+                            const float* kptr = kernels + (m + n) * cin * 9 + idx * vstep;
+                            s0 = avx_madd_ps<fma>(r[0][p + 0][idx], _mm256_load_ps(kptr + cin * 0), s0);
+                            s1 = avx_madd_ps<fma>(r[0][p + 1][idx], _mm256_load_ps(kptr + cin * 1), s1);
+                            s2 = avx_madd_ps<fma>(r[0][p + 2][idx], _mm256_load_ps(kptr + cin * 2), s2);
+                            s0 = avx_madd_ps<fma>(r[1][p + 0][idx], _mm256_load_ps(kptr + cin * 3), s0);
+                            s1 = avx_madd_ps<fma>(r[1][p + 1][idx], _mm256_load_ps(kptr + cin * 4), s1);
+                            s2 = avx_madd_ps<fma>(r[1][p + 2][idx], _mm256_load_ps(kptr + cin * 5), s2);
+                            s0 = avx_madd_ps<fma>(r[2][p + 0][idx], _mm256_load_ps(kptr + cin * 6), s0);
+                            s1 = avx_madd_ps<fma>(r[2][p + 1][idx], _mm256_load_ps(kptr + cin * 7), s1);
+                            s2 = avx_madd_ps<fma>(r[2][p + 2][idx], _mm256_load_ps(kptr + cin * 8), s2);
+                        }
+                        sum[n] = _mm256_add_ps(s0, _mm256_add_ps(s1, s2));
+                    }
+                    v[m / vstep] = _mm256_max_ps(_mm256_add_ps(avx_hsum8_ps(sum), _mm256_loadu_ps(biases + m)), _mm256_setzero_ps());
+                }
+                store(j + p, v);
+            }
+        }
+    }
+    // src must have a 1-pixel replicated border, src and dst are stored as halves if f16
+    template <bool fma, bool f16, int cin, int cout, int block>
+    inline void conv3x3_avx_block(const Image& src, Image& dst, const float* const kernels, const float* const biases)
+    {
+        int step = src.stride() / src.elementSize();
+
+        filterRows([=](const int /*i*/, const int w, const void* const sptr, void* const dptr) {
+            auto out = static_cast<avx_storage_t<f16>*>(dptr);
+            conv3x3_avx_block_row<fma, f16, cin, cout, block>(static_cast<const avx_storage_t<f16>*>(sptr), step, w, kernels, biases, [=](const int j, const __m256* const v) {
+                for (int m = 0; m < cout; m += 8) avx_store8_ps<f16>(out + j * cout + m, v[m / 8]);
+            });
+        }, src, dst);
+    }
+    // kernels must be packed by avx_cin1_pack, dst is stored as halves if f16
+    template <typename IN, bool f16, int cout>
     inline void conv3x3_avx_cin1(const Image& src, Image& dst, const float* const kernels, const float* const biases)
     {
+        static_assert(cout % 8 == 0, "cout must be a multiple of 8");
+
         int w = src.width(), h = src.height();
         int step = src.stride() / src.elementSize();
 
         filter([=](const int i, const int j, const void* const sptr, void* const dptr) {
             auto in = static_cast<const IN*>(sptr);
-            auto out = static_cast<OUT*>(dptr);
+            auto out = static_cast<avx_storage_t<f16>*>(dptr);
 
             auto sp = i < h - 1 ? +step : 0;
             auto sn = i > 0 ? -step : 0;
@@ -300,66 +459,463 @@ namespace ac::core::cpu
                 toFloat<IN>(*tl));
             auto r8 = toFloat<IN>(*br);
 
+            alignas(32) float sums[cout];
             for (int n = 0; n < cout; n++)
             {
-                __m256 k = _mm256_loadu_ps(kernels + n * 9 + 0);
+                __m256 k = _mm256_load_ps(kernels + n * 16 + 0);
                 auto sum = avx_hsum_ps(_mm256_mul_ps(r, k));
-                auto k8 = *(kernels + n * 9 + 8);
-                out[n] = relu<OUT>(sum + k8 * r8 + biases[n]);
+                auto k8 = *(kernels + n * 16 + 8);
+                sums[n] = sum + k8 * r8 + biases[n];
             }
+            for (int m = 0; m < cout; m += 8) avx_store8_ps<f16>(out + m, _mm256_max_ps(_mm256_load_ps(sums + m), _mm256_setzero_ps()));
         }, src, dst);
     }
-    template <typename OUT, int cin, int cout>
+    // iterate over the source pixels, the channels of each of them are loaded once for its 2x2 output block,
+    // the blocks of `span` pixels are collected and written as two rows, with non-temporal stores for a large dst.
+    // kernels must be packed by avx_deconv2x2_pack, src is stored as halves if f16
+    template <typename OUT, bool f16, int cin, int cout, int span>
     inline void deconv2x2_avx_float(const Image& src, Image& dst, const float* const kernels)
     {
-        filter([=](const int i, const int j, const void* const sptr, void* const dptr) {
-            auto in = static_cast<const float*>(sptr);
-            auto out = static_cast<OUT*>(dptr);
+        static_assert(!f16 || cin % 8 == 0, "cin must be a multiple of 8 for halves");
 
-            const int index = ((i & 1) << 1) + (j & 1);
+        const bool nt = detail::nonTemporal(dst);
+
+        parallelFor(0, src.height(), [=](const int i) {
+            auto in = static_cast<const avx_storage_t<f16>*>(src.ptr(0, i));
+            OUT* const out[] = { static_cast<OUT*>(dst.ptr(0, i * 2)), static_cast<OUT*>(dst.ptr(0, i * 2 + 1)) };
 
             constexpr int vstep = 8;
             constexpr int count = cin / vstep;
             constexpr int remain = cin % vstep;
-            constexpr int nstep = 4 * cout;
+            constexpr int cinp = align(cin, vstep);
 
-            __m256 r[count + (remain ? 1 : 0)] = {};
-            for (int idx = 0; idx < count; idx++)  r[idx] = _mm256_loadu_ps(in + idx * vstep);
+            alignas(32) OUT buffer[2][span * 2 * cout];
 
-            if constexpr (remain) r[count] = _mm256_set_ps(0.0f, remain > 6 ? (in + count * vstep)[6] : 0.0f, remain > 5 ? (in + count * vstep)[5] : 0.0f, remain > 4 ? (in + count * vstep)[4] : 0.0f, remain > 3 ? (in + count * vstep)[3] : 0.0f, remain > 2 ? (in + count * vstep)[2] : 0.0f, remain > 1 ? (in + count * vstep)[1] : 0.0f, (in + count * vstep)[0]);
-            for (int n = 0; n < cout; n++)
+            const int w = src.width();
+            for (int j = 0; j < w; j += span)
             {
-                float sum = 0.0f;
-                __m256 k[count + (remain ? 1 : 0)] = {};
+                const int valid = w - j < span ? w - j : span;
+                for (int p = 0; p < valid; p++)
+                {
+                    auto ptr = in + (j + p) * cin;
+
+                    __m256 r[count + (remain ? 1 : 0)] = {};
+                    for (int idx = 0; idx < count; idx++)  r[idx] = avx_load8_ps<f16>(ptr + idx * vstep);
+
+                    if constexpr (remain) r[count] = _mm256_set_ps(0.0f, remain > 6 ? (ptr + count * vstep)[6] : 0.0f, remain > 5 ? (ptr + count * vstep)[5] : 0.0f, remain > 4 ? (ptr + count * vstep)[4] : 0.0f, remain > 3 ? (ptr + count * vstep)[3] : 0.0f, remain > 2 ? (ptr + count * vstep)[2] : 0.0f, remain > 1 ? (ptr + count * vstep)[1] : 0.0f, (ptr + count * vstep)[0]);
+                    for (int index = 0; index < 4; index++)
+                        for (int n = 0; n < cout; n++)
+                        {
+                            auto kptr = kernels + (index * cout + n) * cinp;
+                            float sum = 0.0f;
+                            for (int idx = 0; idx < count + (remain ? 1 : 0); idx++) sum += avx_hsum_ps(_mm256_mul_ps(r[idx], _mm256_load_ps(kptr + idx * vstep)));
+                            buffer[index >> 1][(p * 2 + (index & 1)) * cout + n] = fromFloat<OUT>(sum);
+                        }
+                }
+                avx_store_blocks(out, buffer, j, valid, cout, nt);
+            }
+            if (nt) _mm_sfence();
+        });
+    }
+    // conv3x3_avx_block followed by deconv2x2_avx_float with cout == 1, the 2x2 output block of each pixel is computed as soon as the pixel is,
+    // they are written every `span` pixels as deconv2x2_avx_float does.
+    // src must have a 1-pixel replicated border and is stored as halves if f16, dst is twice the size of src,
+    // deconvKernels must be packed by avx_deconv2x2_pack
+    template <typename OUT, bool fma, bool f16, int cin, int block, int span>
+    inline void conv3x3_deconv2x2_avx(const Image& src, Image& dst, const float* const kernels, const float* const biases, const float* const deconvKernels)
+    {
+        constexpr int vstep = 8;
+        constexpr int count = cin / vstep;
+
+        int step = src.stride() / src.elementSize();
+        const bool nt = detail::nonTemporal(dst);
+
+        parallelFor(0, src.height(), [=](const int i) {
+            OUT* const out[] = { static_cast<OUT*>(dst.ptr(0, i * 2)), static_cast<OUT*>(dst.ptr(0, i * 2 + 1)) };
+            alignas(32) OUT buffer[2][span * 2];
+            const int w = src.width();
+            conv3x3_avx_block_row<fma, f16, cin, cin, block>(static_cast<const avx_storage_t<f16>*>(src.ptr(0, i)), step, w, kernels, biases, [&](const int j, const __m256* const v) {
+                const int p = j % span;
+                __m256 r[count];
                 for (int idx = 0; idx < count; idx++)
                 {
-                    auto kptr = kernels + idx * vstep * cout * 4 + cout * index;
-                    k[idx] = _mm256_set_ps(kptr[7 * nstep + n], kptr[6 * nstep + n], kptr[5 * nstep + n], kptr[4 * nstep + n], kptr[3 * nstep + n], kptr[2 * nstep + n], kptr[1 * nstep + n], kptr[0 * nstep + n]);
-                    sum += avx_hsum_ps(_mm256_mul_ps(r[idx], k[idx]));
+                    // round as the stored feature map would be
+#               ifdef AC_CORE_WITH_F16C
+                    if constexpr (f16) r[idx] = _mm256_cvtph_ps(_mm256_cvtps_ph(v[idx], _MM_FROUND_TO_NEAREST_INT));
+                    else
+#               endif
+                    r[idx] = v[idx];
                 }
-                if constexpr (remain)
+                for (int index = 0; index < 4; index++)
                 {
-                    auto kptr = kernels + count * vstep * cout * 4 + cout * index;
-                    k[count] = _mm256_set_ps(0.0f, remain > 6 ? kptr[6 * nstep + n] : 0.0f, remain > 5 ? kptr[5 * nstep + n] : 0.0f, remain > 4 ? kptr[4 * nstep + n] : 0.0f, remain > 3 ? kptr[3 * nstep + n] : 0.0f, remain > 2 ? kptr[2 * nstep + n] : 0.0f, remain > 1 ? kptr[1 * nstep + n] : 0.0f, kptr[0 * nstep + n]);
-                    sum += avx_hsum_ps(_mm256_mul_ps(r[count], k[count]));
+                    float sum = 0.0f;
+                    for (int idx = 0; idx < count; idx++) sum += avx_hsum_ps(_mm256_mul_ps(r[idx], _mm256_load_ps(deconvKernels + index * cin + idx * vstep)));
+                    buffer[index >> 1][p * 2 + (index & 1)] = fromFloat<OUT>(sum);
+                }
+                if (p == span - 1 || j == w - 1) avx_store_blocks(out, buffer, j - p, p + 1, 1, nt);
+            });
+            if (nt) _mm_sfence();
+        });
+    }
+    template <bool fma, bool f16>
+    inline void conv3x3_deconv2x2_8to1_avx(const Image& src, Image& dst, const float* const kernels, const float* const biases, const float* const deconvKernels)
+    {
+        switch (dst.type())
+        {
+        case Image::UInt8:
+            conv3x3_deconv2x2_avx<std::uint8_t, fma, f16, 8, 8, 16>(src, dst, kernels, biases, deconvKernels);
+            break;
+        case Image::UInt16:
+            conv3x3_deconv2x2_avx<std::uint16_t, fma, f16, 8, 8, 16>(src, dst, kernels, biases, deconvKernels);
+            break;
+        case Image::Float32:
+            conv3x3_deconv2x2_avx<float, fma, f16, 8, 8, 16>(src, dst, kernels, biases, deconvKernels);
+            break;
+        }
+    }
+
+    // kernels must be packed by avx_broadcast_pack
+    template <bool fma, typename IN, int cin, int cout>
+    inline void conv3x3_avx_broadcast(const Image& src, Image& dst, const float* const kernels, const float* const biases)
+    {
+        constexpr int vstep = 8;
+        constexpr int count = cout / vstep;
+        static_assert(cout % vstep == 0, "cout must be a multiple of 8");
+
+        int w = src.width(), h = src.height();
+        int step = src.stride() / src.elementSize();
+
+        const float* const kptr = kernels;
+
+        filter([=](const int i, const int j, const void* const sptr, void* const dptr) {
+            auto in = static_cast<const IN*>(sptr);
+            auto out = static_cast<float*>(dptr);
+
+            auto sp = i < h - 1 ? +step : 0;
+            auto sn = i > 0 ? -step : 0;
+            auto cp = j < w - 1 ? +cin : 0;
+            auto cn = j > 0 ? -cin : 0;
+
+            auto tl = in + sn + cn, tc = in + sn, tr = in + sn + cp;
+            auto ml = in + cn, mc = in, mr = in + cp;
+            auto bl = in + sp + cn, bc = in + sp, br = in + sp + cp;
+
+            __m256 s0[count] = {};
+            __m256 s1[count] = {};
+            __m256 s2[count] = {};
+
+            for (int idx = 0; idx < count; idx++) s0[idx] = _mm256_loadu_ps(biases + idx * vstep);
+
+            for (int c = 0; c < cin; c++)
+            {
+                __m256 r0 = _mm256_set1_ps(toFloat<IN>(tl[c]));
+                __m256 r1 = _mm256_set1_ps(toFloat<IN>(tc[c]));
+                __m256 r2 = _mm256_set1_ps(toFloat<IN>(tr[c]));
+                __m256 r3 = _mm256_set1_ps(toFloat<IN>(ml[c]));
+                __m256 r4 = _mm256_set1_ps(toFloat<IN>(mc[c]));
+                __m256 r5 = _mm256_set1_ps(toFloat<IN>(mr[c]));
+                __m256 r6 = _mm256_set1_ps(toFloat<IN>(bl[c]));
+                __m256 r7 = _mm256_set1_ps(toFloat<IN>(bc[c]));
+                __m256 r8 = _mm256_set1_ps(toFloat<IN>(br[c]));
+
+                for (int idx = 0; idx < count; idx++)
+                {
+                    auto k = kptr + c * cout + idx * vstep;
+
+                    s0[idx] = avx_madd_ps<fma>(r0, _mm256_load_ps(k + 0 * cin * cout), s0[idx]);
+                    s1[idx] = avx_madd_ps<fma>(r1, _mm256_load_ps(k + 1 * cin * cout), s1[idx]);
+                    s2[idx] = avx_madd_ps<fma>(r2, _mm256_load_ps(k + 2 * cin * cout), s2[idx]);
+                    s0[idx] = avx_madd_ps<fma>(r3, _mm256_load_ps(k + 3 * cin * cout), s0[idx]);
+                    s1[idx] = avx_madd_ps<fma>(r4, _mm256_load_ps(k + 4 * cin * cout), s1[idx]);
+                    s2[idx] = avx_madd_ps<fma>(r5, _mm256_load_ps(k + 5 * cin * cout), s2[idx]);
+                    s0[idx] = avx_madd_ps<fma>(r6, _mm256_load_ps(k + 6 * cin * cout), s0[idx]);
+                    s1[idx] = avx_madd_ps<fma>(r7, _mm256_load_ps(k + 7 * cin * cout), s1[idx]);
+                    s2[idx] = avx_madd_ps<fma>(r8, _mm256_load_ps(k + 8 * cin * cout), s2[idx]);
                 }
-                out[n] = fromFloat<OUT>(sum);
             }
+
+            for (int idx = 0; idx < count; idx++)
+                _mm256_storeu_ps(out + idx * vstep, _mm256_max_ps(_mm256_add_ps(s0[idx], _mm256_add_ps(s1[idx], s2[idx])), _mm256_setzero_ps()));
         }, src, dst);
     }
+    // Winograd F(2x2, 3x3), transform conv3x3 kernels g from [cout][9][cin] to U = G * g * G^T of [16][cin][cout]
+    template <int cin, int cout>
+    inline static void avx_winograd_f2x3_transform(const float* const kernels, float* const transformed) noexcept
+    {
+        constexpr float G[4][3] = { { 1.0f, 0.0f, 0.0f }, { 0.5f, 0.5f, 0.5f }, { 0.5f, -0.5f, 0.5f }, { 0.0f, 0.0f, 1.0f } };
+        for (int n = 0; n < cout; n++)
+            for (int c = 0; c < cin; c++)
+            {
+                auto g = [=](const int y, const int x) { return kernels[n * cin * 9 + (y * 3 + x) * cin + c]; };
+                for (int y = 0; y < 4; y++)
+                    for (int x = 0; x < 4; x++)
+                    {
+                        float sum = 0.0f;
+                        for (int a = 0; a < 3; a++)
+                            for (int b = 0; b < 3; b++) sum += G[y][a] * g(a, b) * G[x][b];
+                        transformed[((y * 4 + x) * cin + c) * cout + n] = sum;
+                    }
+            }
+    }
+    // Winograd F(2x2, 3x3), each 2x2 output tile takes 16 * cin * cout multiplications instead of 36 * cin * cout.
+    // `block` horizontally adjacent tiles per iteration share the loads of the transformed kernels,
+    // the tiles past the right edge repeat the last one and are not stored.
+    // src must have a 1-pixel replicated border, reads past it at the bottom and right edges are clamped to it,
+    // they only affect outputs outside the image.
+    template <bool fma, int cin, int cout, int block>
+    inline void conv3x3_avx_winograd(const Image& src, Image& dst, const float* const kernels, const float* const biases)
+    {
+        static_assert(cin == 8 && cout == 8, "cin and cout must be 8");
+
+        const int w = src.width(), h = src.height();
+        const int tw = (w + 1) / 2, th = (h + 1) / 2;
+
+        parallelFor(0, th, [&](const int ty) {
+            const int y0 = ty * 2;
+            const float* rows[4];
+            for (int k = 0; k < 4; k++) rows[k] = static_cast<const float*>(src.ptr(0, std::min(y0 - 1 + k, h)));
+            float* outs[2] = { static_cast<float*>(dst.ptr(0, y0)), static_cast<float*>(dst.ptr(0, std::min(y0 + 1, h - 1))) };
+
+            alignas(32) float v[block][16][cin];
+
+            for (int tx = 0; tx < tw; tx += block)
+            {
+                // V = B^T * d * B for each tile, vectorized over the input channels
+                for (int t = 0; t < block; t++)
+                {
+                    const int x0 = std::min(tx + t, tw - 1) * 2;
+                    __m256 d[4][4];
+                    for (int y = 0; y < 4; y++)
+                        for (int x = 0; x < 4; x++) d[y][x] = _mm256_loadu_ps(rows[y] + std::min(x0 - 1 + x, w) * cin);
+                    __m256 r[4][4];
+                    for (int x = 0; x < 4; x++)
+                    {
+                        r[0][x] = _mm256_sub_ps(d[0][x], d[2][x]);
+                        r[1][x] = _mm256_add_ps(d[1][x], d[2][x]);
+                        r[2][x] = _mm256_sub_ps(d[2][x], d[1][x]);
+                        r[3][x] = _mm256_sub_ps(d[1][x], d[3][x]);
+                    }
+                    for (int y = 0; y < 4; y++)
+                    {
+                        _mm256_store_ps(v[t][y * 4 + 0], _mm256_sub_ps(r[y][0], r[y][2]));
+                        _mm256_store_ps(v[t][y * 4 + 1], _mm256_add_ps(r[y][1], r[y][2]));
+                        _mm256_store_ps(v[t][y * 4 + 2], _mm256_sub_ps(r[y][2], r[y][1]));
+                        _mm256_store_ps(v[t][y * 4 + 3], _mm256_sub_ps(r[y][1], r[y][3]));
+                    }
+                }
+                // M = U . V for each of the 16 positions, vectorized over the output channels
+                __m256 m[block][16];
+                for (int pos = 0; pos < 16; pos += 2)
+                {
+                    // two positions at once for enough independent sums
+                    __m256 s[2][block];
+                    for (int t = 0; t < block; t++) s[0][t] = s[1][t] = _mm256_setzero_ps();
+                    for (int c = 0; c < cin; c++)
+                    {
+                        __m256 u0 = _mm256_load_ps(kernels + ((pos + 0) * cin + c) * cout);
+                        __m256 u1 = _mm256_load_ps(kernels + ((pos + 1) * cin + c) * cout);
+                        for (int t = 0; t < block; t++)
+                        {
+                            s[0][t] = avx_madd_ps<fma>(_mm256_broadcast_ss(&v[t][pos + 0][c]), u0, s[0][t]);
+                            s[1][t] = avx_madd_ps<fma>(_mm256_broadcast_ss(&v[t][pos + 1][c]), u1, s[1][t]);
+                        }
+                    }
+                    for (int t = 0; t < block; t++)
+                    {
+                        m[t][pos + 0] = s[0][t];
+                        m[t][pos + 1] = s[1][t];
+                    }
+                }
+                // Y = A^T * M * A
+                const __m256 bias = _mm256_loadu_ps(biases);
+                for (int t = 0; t < block && tx + t < tw; t++)
+                {
+                    __m256 a[2][4];
+                    for (int x = 0; x < 4; x++)
+                    {
+                        a[0][x] = _mm256_add_ps(_mm256_add_ps(m[t][0 + x], m[t][4 + x]), m[t][8 + x]);
+                        a[1][x] = _mm256_sub_ps(_mm256_sub_ps(m[t][4 + x], m[t][8 + x]), m[t][12 + x]);
+                    }
+                    const int x0 = (tx + t) * 2;
+                    for (int y = 0; y < 2 && y0 + y < h; y++)
+                    {
+                        __m256 o0 = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(a[y][0], a[y][1]), a[y][2]), bias);
+                        _mm256_storeu_ps(outs[y] + x0 * cout, _mm256_max_ps(o0, _mm256_setzero_ps()));
+                        if (x0 + 1 < w)
+                        {
+                            __m256 o1 = _mm256_add_ps(_mm256_sub_ps(_mm256_sub_ps(a[y][1], a[y][2]), a[y][3]), bias);
+                            _mm256_storeu_ps(outs[y] + (x0 + 1) * cout, _mm256_max_ps(o1, _mm256_setzero_ps()));
+                        }
+                    }
+                }
+            }
+        });
+    }
+
+    // transpose the 8x8 matrix of the rows in `r`
+    inline static void avx_transpose8_ps(__m256* const r) noexcept
+    {
+        __m256 t0 = _mm256_unpacklo_ps(r[0], r[1]);
+        __m256 t1 = _mm256_unpackhi_ps(r[0], r[1]);
+        __m256 t2 = _mm256_unpacklo_ps(r[2], r[3]);
+        __m256 t3 = _mm256_unpackhi_ps(r[2], r[3]);
+        __m256 t4 = _mm256_unpacklo_ps(r[4], r[5]);
+        __m256 t5 = _mm256_unpackhi_ps(r[4], r[5]);
+        __m256 t6 = _mm256_unpacklo_ps(r[6], r[7]);
+        __m256 t7 = _mm256_unpackhi_ps(r[6], r[7]);
+        __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+        r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+        r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+        r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+        r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+        r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+        r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+        r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+        r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+    }
+    // the register tile of the GEMM, C[4][24] = B[4][9 * cin] * A[9 * cin][24], B is dense and `ldc` is the row stride of C.
+    // A is not stored, row (y * 3 + x) * cin + ch of it is row y * cin + ch of the planar input `a` shifted by x, `lda` is the row stride of `a`.
+    template <bool fma, int cin>
+    inline static void avx_gemm_4x24(const float* const a, const int lda, const float* const b, float* const c, const int ldc) noexcept
+    {
+        constexpr int K = 9 * cin;
+        __m256 s[4][3];
+        for (int r = 0; r < 4; r++) s[r][0] = s[r][1] = s[r][2] = _mm256_setzero_ps();
+        for (int y = 0; y < 3; y++)
+            for (int ch = 0; ch < cin; ch++)
+                for (int x = 0; x < 3; x++)
+                {
+                    const int k = (y * 3 + x) * cin + ch;
+                    auto row = a + (y * cin + ch) * lda + x;
+                    __m256 a0 = _mm256_loadu_ps(row + 0);
+                    __m256 a1 = _mm256_loadu_ps(row + 8);
+                    __m256 a2 = _mm256_loadu_ps(row + 16);
+                    for (int r = 0; r < 4; r++)
+                    {
+                        __m256 v = _mm256_broadcast_ss(b + r * K + k);
+                        s[r][0] = avx_madd_ps<fma>(v, a0, s[r][0]);
+                        s[r][1] = avx_madd_ps<fma>(v, a1, s[r][1]);
+                        s[r][2] = avx_madd_ps<fma>(v, a2, s[r][2]);
+                    }
+                }
+        for (int r = 0; r < 4; r++)
+        {
+            _mm256_store_ps(c + r * ldc + 0, s[r][0]);
+            _mm256_store_ps(c + r * ldc + 8, s[r][1]);
+            _mm256_store_ps(c + r * ldc + 16, s[r][2]);
+        }
+    }
+    // lower a conv3x3 layer to C[cout][pixels] = B[cout][9 * cin] * A[9 * cin][pixels] over strips of `strip` pixels of a row,
+    // B is the kernels as they are. For each strip the 3 input rows are converted to planar float once, the rows of the im2col matrix A
+    // are these rows shifted by 0 to 2 pixels, so the register tile reads them in place instead of copying them.
+    // All the scratch buffers are on the stack of the calling thread and stay in L1 cache.
+    // with cin > 1 the input must be float with a 1-pixel replicated border, with cin == 1 it is any type and is clamped at the edges.
+    template <bool fma, typename IN, int cin, int cout>
+    inline void conv3x3_avx_gemm(const Image& src, Image& dst, const float* const kernels, const float* const biases)
+    {
+        constexpr int strip = 96; // a multiple of the 24 pixels of the register tile
+        constexpr int ldp = strip + 8; // room for the 2 extra columns and the reads of the last register tile past them
+        static_assert((cin == 1 || cin % 8 == 0) && cout % 8 == 0, "cin must be 1 or a multiple of 8 and cout must be a multiple of 8");
+
+        int h = src.height();
+        int step = src.stride() / src.elementSize();
+
+        filterRows([=](const int i, const int w, const void* const sptr, void* const dptr) {
+            auto in = static_cast<const IN*>(sptr);
+            auto out = static_cast<float*>(dptr);
+
+            const IN* rows[3] = { in - step, in, in + step };
+            if constexpr (cin == 1)
+            {
+                if (i == 0) rows[0] = in;
+                if (i == h - 1) rows[2] = in;
+            }
+
+            alignas(32) float planar[3][cin][ldp] = {};
+            alignas(32) float c[cout][strip];
+
+            for (int j0 = 0; j0 < w; j0 += strip)
+            {
+                const int n = w - j0 < strip ? w - j0 : strip;
+                // columns j0 - 1 to j0 + n of the 3 rows, [channel][column]
+                for (int y = 0; y < 3; y++)
+                {
+                    if constexpr (cin == 1)
+                    {
+                        for (int x = 0; x < n + 2; x++)
+                        {
+                            const int col = j0 - 1 + x;
+                            planar[y][0][x] = toFloat<IN>(rows[y][col < 0 ? 0 : (col < w ? col : w - 1)]);
+                        }
+                    }
+                    else
+                    {
+                        auto row = rows[y] + (j0 - 1) * cin;
+                        int x = 0;
+                        for (; x + 8 <= n + 2; x += 8)
+                            for (int g = 0; g < cin; g += 8)
+                            {
+                                __m256 r[8];
+                                for (int q = 0; q < 8; q++) r[q] = _mm256_loadu_ps(row + (x + q) * cin + g);
+                                avx_transpose8_ps(r);
+                                for (int q = 0; q < 8; q++) _mm256_store_ps(&planar[y][g + q][x], r[q]);
+                            }
+                        for (; x < n + 2; x++)
+                            for (int ch = 0; ch < cin; ch++) planar[y][ch][x] = row[x * cin + ch];
+                    }
+                }
+                for (int m = 0; m < cout; m += 4)
+                    for (int p = 0; p < n; p += 24) avx_gemm_4x24<fma, cin>(&planar[0][0][p], ldp, kernels + m * 9 * cin, &c[m][p], strip);
+
+                // back to [pixel][channel] with bias and relu
+                for (int g = 0; g < cout; g += 8)
+                {
+                    const __m256 bias = _mm256_loadu_ps(biases + g);
+                    for (int p = 0; p < n; p += 8)
+                    {
+                        __m256 r[8];
+                        for (int q = 0; q < 8; q++) r[q] = _mm256_load_ps(&c[g + q][p]);
+                        avx_transpose8_ps(r);
+                        for (int q = 0; q < 8 && p + q < n; q++)
+                            _mm256_storeu_ps(out + (j0 + p + q) * cout + g, _mm256_max_ps(_mm256_add_ps(r[q], bias), _mm256_setzero_ps()));
+                    }
+                }
+            }
+        }, src, dst);
+    }
+
+    template <typename IN, int cin, int cout>
+    inline void conv3x3_avx_broadcast(const Image& src, Image& dst, const float* const kernels, const float* const biases)
+    {
+#ifdef AC_CORE_WITH_FMA
+        if (dispatch::supportFMA())
+            conv3x3_avx_broadcast<true, IN, cin, cout>(src, dst, kernels, biases);
+        else
+            conv3x3_avx_broadcast<false, IN, cin, cout>(src, dst, kernels, biases);
+#else
+        conv3x3_avx_broadcast<false, IN, cin, cout>(src, dst, kernels, biases);
+#endif
+    }
 
     void conv3x3_1to8_avx(const Image& src, Image& dst, const float* kernels, const float* biases)
     {
         switch (src.type())
         {
         case Image::UInt8:
-            conv3x3_avx_cin1<std::uint8_t, float, 8>(src, dst, kernels, biases);
+            conv3x3_avx_cin1<std::uint8_t, false, 8>(src, dst, kernels, biases);
             break;
         case Image::UInt16:
-            conv3x3_avx_cin1<std::uint16_t, float, 8>(src, dst, kernels, biases);
+            conv3x3_avx_cin1<std::uint16_t, false, 8>(src, dst, kernels, biases);
             break;
         case Image::Float32:
-            conv3x3_avx_cin1<float, float, 8>(src, dst, kernels, biases);
+            conv3x3_avx_cin1<float, false, 8>(src, dst, kernels, biases);
             break;
         }
     }
@@ -367,11 +923,66 @@ namespace ac::core::cpu
     {
 #ifdef AC_CORE_WITH_FMA
         if (dispatch::supportFMA())
-            conv3x3_avx_fma_float<float, 8, 8>(src, dst, kernels, biases);
+            conv3x3_avx_block<true, false, 8, 8, 8>(src, dst, kernels, biases);
+        else
+            conv3x3_avx_block<false, false, 8, 8, 8>(src, dst, kernels, biases);
+#else
+        conv3x3_avx_block<false, false, 8, 8, 8>(src, dst, kernels, biases);
+#endif
+    }
+    void conv3x3_1to8_avx_gemm(const Image& src, Image& dst, const float* kernels, const float* biases)
+    {
+#ifdef AC_CORE_WITH_FMA
+        if (dispatch::supportFMA())
+        {
+            switch (src.type())
+            {
+            case Image::UInt8:
+                conv3x3_avx_gemm<true, std::uint8_t, 1, 8>(src, dst, kernels, biases);
+                break;
+            case Image::UInt16:
+                conv3x3_avx_gemm<true, std::uint16_t, 1, 8>(src, dst, kernels, biases);
+                break;
+            case Image::Float32:
+                conv3x3_avx_gemm<true, float, 1, 8>(src, dst, kernels, biases);
+                break;
+            }
+            return;
+        }
+#endif
+        switch (src.type())
+        {
+        case Image::UInt8:
+            conv3x3_avx_gemm<false, std::uint8_t, 1, 8>(src, dst, kernels, biases);
+            break;
+        case Image::UInt16:
+            conv3x3_avx_gemm<false, std::uint16_t, 1, 8>(src, dst, kernels, biases);
+            break;
+        case Image::Float32:
+            conv3x3_avx_gemm<false, float, 1, 8>(src, dst, kernels, biases);
+            break;
+        }
+    }
+    void conv3x3_8to8_avx_gemm(const Image& src, Image& dst, const float* kernels, const float* biases)
+    {
+#ifdef AC_CORE_WITH_FMA
+        if (dispatch::supportFMA())
+            conv3x3_avx_gemm<true, float, 8, 8>(src, dst, kernels, biases);
         else
-            conv3x3_avx_float<float, 8, 8>(src, dst, kernels, biases);
+            conv3x3_avx_gemm<false, float, 8, 8>(src, dst, kernels, biases);
 #else
-        conv3x3_avx_float<float, 8, 8>(src, dst, kernels, biases);
+        conv3x3_avx_gemm<false, float, 8, 8>(src, dst, kernels, biases);
+#endif
+    }
+    void conv3x3_8to8_avx_winograd(const Image& src, Image& dst, const float* kernels, const float* biases)
+    {
+#ifdef AC_CORE_WITH_FMA
+        if (dispatch::supportFMA())
+            conv3x3_avx_winograd<true, 8, 8, 4>(src, dst, kernels, biases);
+        else
+            conv3x3_avx_winograd<false, 8, 8, 4>(src, dst, kernels, biases);
+#else
+        conv3x3_avx_winograd<false, 8, 8, 4>(src, dst, kernels, biases);
 #endif
     }
     void deconv2x2_8to1_avx(const Image& src, Image& dst, const float* kernels)
@@ -379,14 +990,129 @@ namespace ac::core::cpu
         switch (dst.type())
         {
         case Image::UInt8:
-            deconv2x2_avx_float<std::uint8_t, 8, 1>(src, dst, kernels);
+            deconv2x2_avx_float<std::uint8_t, false, 8, 1, 16>(src, dst, kernels);
             break;
         case Image::UInt16:
-            deconv2x2_avx_float<std::uint16_t, 8, 1>(src, dst, kernels);
+            deconv2x2_avx_float<std::uint16_t, false, 8, 1, 16>(src, dst, kernels);
             break;
         case Image::Float32:
-            deconv2x2_avx_float<float, 8, 1>(src, dst, kernels);
+            deconv2x2_avx_float<float, false, 8, 1, 16>(src, dst, kernels);
             break;
         }
     }
+    void conv3x3_8to8_deconv2x2_8to1_avx(const Image& src, Image& dst, const float* kernels, const float* biases, const float* deconvKernels)
+    {
+#ifdef AC_CORE_WITH_FMA
+        if (dispatch::supportFMA())
+            conv3x3_deconv2x2_8to1_avx<true, false>(src, dst, kernels, biases, deconvKernels);
+        else
+            conv3x3_deconv2x2_8to1_avx<false, false>(src, dst, kernels, biases, deconvKernels);
+#else
+        conv3x3_deconv2x2_8to1_avx<false, false>(src, dst, kernels, biases, deconvKernels);
+#endif
+    }
+    void conv3x3_1to8_avx_broadcast(const Image& src, Image& dst, const float* kernels, const float* biases)
+    {
+        switch (src.type())
+        {
+        case Image::UInt8:
+            conv3x3_avx_broadcast<std::uint8_t, 1, 8>(src, dst, kernels, biases);
+            break;
+        case Image::UInt16:
+            conv3x3_avx_broadcast<std::uint16_t, 1, 8>(src, dst, kernels, biases);
+            break;
+        case Image::Float32:
+            conv3x3_avx_broadcast<float, 1, 8>(src, dst, kernels, biases);
+            break;
+        }
+    }
+    void conv3x3_8to8_avx_broadcast(const Image& src, Image& dst, const float* kernels, const float* biases)
+    {
+        conv3x3_avx_broadcast<float, 8, 8>(src, dst, kernels, biases);
+    }
+#ifdef AC_CORE_WITH_F16C
+    void conv3x3_1to8_avx_fp16(const Image& src, Image& dst, const float* kernels, const float* biases)
+    {
+        switch (src.type())
+        {
+        case Image::UInt8:
+            conv3x3_avx_cin1<std::uint8_t, true, 8>(src, dst, kernels, biases);
+            break;
+        case Image::UInt16:
+            conv3x3_avx_cin1<std::uint16_t, true, 8>(src, dst, kernels, biases);
+            break;
+        case Image::Float32:
+            conv3x3_avx_cin1<float, true, 8>(src, dst, kernels, biases);
+            break;
+        }
+    }
+    void conv3x3_8to8_avx_fp16(const Image& src, Image& dst, const float* kernels, const float* biases)
+    {
+#   ifdef AC_CORE_WITH_FMA
+        if (dispatch::supportFMA())
+            conv3x3_avx_block<true, true, 8, 8, 8>(src, dst, kernels, biases);
+        else
+            conv3x3_avx_block<false, true, 8, 8, 8>(src, dst, kernels, biases);
+#   else
+        conv3x3_avx_block<false, true, 8, 8, 8>(src, dst, kernels, biases);
+#   endif
+    }
+    void deconv2x2_8to1_avx_fp16(const Image& src, Image& dst, const float* kernels)
+    {
+        switch (dst.type())
+        {
+        case Image::UInt8:
+            deconv2x2_avx_float<std::uint8_t, true, 8, 1, 16>(src, dst, kernels);
+            break;
+        case Image::UInt16:
+            deconv2x2_avx_float<std::uint16_t, true, 8, 1, 16>(src, dst, kernels);
+            break;
+        case Image::Float32:
+            deconv2x2_avx_float<float, true, 8, 1, 16>(src, dst, kernels);
+            break;
+        }
+    }
+    void conv3x3_8to8_deconv2x2_8to1_avx_fp16(const Image& src, Image& dst, const float* kernels, const float* biases, const float* deconvKernels)
+    {
+#   ifdef AC_CORE_WITH_FMA
+        if (dispatch::supportFMA())
+            conv3x3_deconv2x2_8to1_avx<true, true>(src, dst, kernels, biases, deconvKernels);
+        else
+            conv3x3_deconv2x2_8to1_avx<false, true>(src, dst, kernels, biases, deconvKernels);
+#   else
+        conv3x3_deconv2x2_8to1_avx<false, true>(src, dst, kernels, biases, deconvKernels);
+#   endif
+    }
+#endif
+
+    int conv3x3_1to8_avx_pack(const float* kernels, float* packed)
+    {
+        if (packed) avx_cin1_pack<8>(kernels, packed);
+        return 8 * 16;
+    }
+    int conv3x3_8to8_avx_pack(const float* kernels, float* packed)
+    {
+        if (packed) std::copy_n(kernels, 8 * 9 * 8, packed);
+        return 8 * 9 * 8;
+    }
+    int conv3x3_8to8_avx_winograd_pack(const float* kernels, float* packed)
+    {
+        if (packed) avx_winograd_f2x3_transform<8, 8>(kernels, packed);
+        return 16 * 8 * 8;
+    }
+    int deconv2x2_8to1_avx_pack(const float* kernels, float* packed)
+    {
+        if (packed) avx_deconv2x2_pack<8, 1>(kernels, packed);
+        return 4 * 1 * 8;
+    }
+    int conv3x3_1to8_avx_broadcast_pack(const float* kernels, float* packed)
+    {
+        if (packed) avx_broadcast_pack<1, 8>(kernels, packed);
+        return 9 * 1 * 8;
+    }
+    int conv3x3_8to8_avx_broadcast_pack(const float* kernels, float* packed)
+    {
+        if (packed) avx_broadcast_pack<8, 8>(kernels, packed);
+        return 9 * 8 * 8;
+    }
 }
@@ -0,0 +1,273 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include <immintrin.h>
+
+#include "AC/Core/Image.hpp"
+#include "AC/Core/Util.hpp"
+
+// int8 inference of ACNet. The feature maps are 8-channel UInt8 images, the output of conv layer l is stored as
+// round(value / scale[l]) saturated to [0, 255], which also applies the ReLU. The weights of the conv3x3_8to8 layers are
+// quantized to int8 per output channel and the products are accumulated in int32 by vpmaddwd, vpmaddubsw would saturate
+// with full-range uint8 activations. Everything else is computed in float.
+namespace ac::core::cpu
+{
+    // [hsum(v0), hsum(v1), ..., hsum(v7)]
+    inline static __m256i avx2_hsum8_epi32(const __m256i* const v) noexcept
+    {
+        __m256i t0 = _mm256_hadd_epi32(_mm256_hadd_epi32(v[0], v[1]), _mm256_hadd_epi32(v[2], v[3]));
+        __m256i t1 = _mm256_hadd_epi32(_mm256_hadd_epi32(v[4], v[5]), _mm256_hadd_epi32(v[6], v[7]));
+        return _mm256_add_epi32(_mm256_permute2x128_si256(t0, t1, 0x20), _mm256_permute2x128_si256(t0, t1, 0x31));
+    }
+    inline static float avx2_hsum_ps(const __m256& v) noexcept
+    {
+        __m128 v128 = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 0x01));
+        __m128 v64 = _mm_add_ps(v128, _mm_movehl_ps(v128, v128));
+        __m128 v32 = _mm_add_ss(v64, _mm_movehdup_ps(v64));
+        return _mm_cvtss_f32(v32);
+    }
+    // round to the nearest integer and saturate to [0, 255]
+    inline static void avx2_store8_u8(std::uint8_t* const ptr, const __m256& v) noexcept
+    {
+        __m256i i = _mm256_cvtps_epi32(v);
+        __m128i w = _mm_packus_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(ptr), _mm_packus_epi16(w, w));
+    }
+    // 16 uint8 of the two pixels at ptr, widened to int16
+    inline static __m256i avx2_load16_u8(const std::uint8_t* const ptr) noexcept
+    {
+        return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr)));
+    }
+    // 8 uint8 of the pixel at p0 and 8 of the pixel at p1, widened to int16
+    inline static __m256i avx2_load16_u8(const std::uint8_t* const p0, const std::uint8_t* const p1) noexcept
+    {
+        __m128i lo = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p0));
+        __m128i hi = p1 ? _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p1)) : _mm_setzero_si128();
+        return _mm256_cvtepu8_epi16(_mm_unpacklo_epi64(lo, hi));
+    }
+    // copy `size` bytes from the 32-byte aligned `src` to `dst`, its 32-byte chunks are written with non-temporal stores if `nt` and `dst` is 32-byte aligned,
+    // a _mm_sfence is needed before they are read by another thread.
+    inline static void avx2_stream(void* const dst, const void* const src, const int size, const bool nt) noexcept
+    {
+        if (nt && !(reinterpret_cast<std::uintptr_t>(dst) & 31))
+        {
+            auto d = static_cast<std::uint8_t*>(dst);
+            auto s = static_cast<const std::uint8_t*>(src);
+            int i = 0;
+            for (; i + 32 <= size; i += 32) _mm256_stream_si256(reinterpret_cast<__m256i*>(d + i), _mm256_load_si256(reinterpret_cast<const __m256i*>(s + i)));
+            if (i < size) std::memcpy(d + i, s + i, size - i);
+        }
+        else std::memcpy(dst, src, size);
+    }
+
+    // the 9 taps of each output channel are divided by the output scale and transposed to [9][cout], so are the biases
+    template <int cout>
+    inline static void avx2_int8_cin1_quantize(const float* const kernels, const float* const biases, const float scaleOut, float* const packed, float* const params) noexcept
+    {
+        for (int n = 0; n < cout; n++)
+        {
+            for (int k = 0; k < 9; k++) packed[k * cout + n] = kernels[n * 9 + k] / scaleOut;
+            params[n] = biases[n] / scaleOut;
+        }
+    }
+    // the weights of each output channel are quantized to int8 with the scale max(|w|) / 127 and stored as 5 groups of 16 int16,
+    // the taps x0 and x1 of rows 0, 1 and 2, the tap x2 of rows 0 and 1, and the tap x2 of row 2 padded with zeros.
+    // params are the requantization multipliers, scaleIn * weight scale / scaleOut, followed by the biases divided by scaleOut.
+    template <int cin, int cout>
+    inline static void avx2_int8_block_quantize(const float* const kernels, const float* const biases, const float scaleIn, const float scaleOut, std::int16_t* const packed, float* const params) noexcept
+    {
+        static_assert(cin == 8, "cin must be 8");
+        for (int n = 0; n < cout; n++)
+        {
+            const float* const k = kernels + n * cin * 9;
+            float scale = 0.0f;
+            for (int i = 0; i < cin * 9; i++) scale = std::max(scale, std::abs(k[i]));
+            scale = scale > 0.0f ? scale / 127.0f : 1.0f;
+
+            auto quantize = [=](const int y, const int x, const int c) { return static_cast<std::int16_t>(std::lrint(k[(y * 3 + x) * cin + c] / scale)); };
+            std::int16_t* const q = packed + n * 5 * 16;
+            for (int c = 0; c < cin; c++)
+            {
+                for (int y = 0; y < 3; y++)
+                {
+                    q[y * 16 + c] = quantize(y, 0, c);
+                    q[y * 16 + cin + c] = quantize(y, 1, c);
+                }
+                q[3 * 16 + c] = quantize(0, 2, c);
+                q[3 * 16 + cin + c] = quantize(1, 2, c);
+                q[4 * 16 + c] = quantize(2, 2, c);
+                q[4 * 16 + cin + c] = 0;
+            }
+            params[n] = scaleIn * scale / scaleOut;
+            params[cout + n] = biases[n] / scaleOut;
+        }
+    }
+    // deconv2x2 kernels from [cin][4][cout] to [4][cout][cin], multiplied by the input scale
+    template <int cin, int cout>
+    inline static void avx2_int8_deconv2x2_quantize(const float* const kernels, const float scaleIn, float* const packed) noexcept
+    {
+        for (int index = 0; index < 4; index++)
+            for (int n = 0; n < cout; n++)
+                for (int c = 0; c < cin; c++) packed[(index * cout + n) * cin + c] = kernels[c * cout * 4 + cout * index + n] * scaleIn;
+    }
+
+    // kernels and biases must be quantized by avx2_int8_cin1_quantize
+    template <typename IN, int cout>
+    inline void conv3x3_avx2_int8_cin1(const Image& src, Image& dst, const float* const kernels, const float* const biases)
+    {
+        static_assert(cout == 8, "cout must be 8");
+
+        int w = src.width(), h = src.height();
+        int step = src.stride() / src.elementSize();
+
+        filter([=](const int i, const int j, const void* const sptr, void* const dptr) {
+            auto in = static_cast<const IN*>(sptr);
+            auto out = static_cast<std::uint8_t*>(dptr);
+
+            auto sp = i < h - 1 ? +step : 0;
+            auto sn = i > 0 ? -step : 0;
+            auto cp = j < w - 1 ? +1 : 0;
+            auto cn = j > 0 ? -1 : 0;
+
+            const IN* const taps[] = {
+                in + sn + cn, in + sn, in + sn + cp,
+                in + cn, in, in + cp,
+                in + sp + cn, in + sp, in + sp + cp
+            };
+
+            __m256 s = _mm256_loadu_ps(biases);
+            for (int k = 0; k < 9; k++) s = _mm256_add_ps(s, _mm256_mul_ps(_mm256_set1_ps(toFloat<IN>(*taps[k])), _mm256_loadu_ps(kernels + k * cout)));
+            avx2_store8_u8(out, s);
+        }, src, dst);
+    }
+    // kernels and biases must be quantized by avx2_int8_block_quantize
+    // src must have a 1-pixel replicated border, so there is no clamping at the edges
+    template <int cin, int cout>
+    inline void conv3x3_avx2_int8_block(const Image& src, Image& dst, const float* const kernels, const float* const biases)
+    {
+        static_assert(cin == 8 && cout == 8, "cin and cout must be 8");
+
+        int step = src.stride() / src.elementSize();
+        auto weights = reinterpret_cast<const std::int16_t*>(kernels);
+
+        filterRows([=](const int /*i*/, const int w, const void* const sptr, void* const dptr) {
+            auto in = static_cast<const std::uint8_t*>(sptr);
+            auto out = static_cast<std::uint8_t*>(dptr);
+
+            const std::uint8_t* rows[] = { in - step, in, in + step };
+
+            const __m256 multiplier = _mm256_loadu_ps(biases);
+            const __m256 bias = _mm256_loadu_ps(biases + cout);
+
+            for (int j = 0; j < w; j++)
+            {
+                const int left = (j - 1) * cin, right = (j + 1) * cin;
+                const __m256i r[5] = {
+                    avx2_load16_u8(rows[0] + left),
+                    avx2_load16_u8(rows[1] + left),
+                    avx2_load16_u8(rows[2] + left),
+                    avx2_load16_u8(rows[0] + right, rows[1] + right),
+                    avx2_load16_u8(rows[2] + right, nullptr)
+                };
+
+                __m256i sum[cout];
+                for (int n = 0; n < cout; n++)
+                {
+                    auto q = reinterpret_cast<const __m256i*>(weights + n * 5 * 16);
+                    __m256i s0 = _mm256_madd_epi16(r[0], _mm256_load_si256(q + 0));
+                    __m256i s1 = _mm256_madd_epi16(r[1], _mm256_load_si256(q + 1));
+                    s0 = _mm256_add_epi32(s0, _mm256_madd_epi16(r[2], _mm256_load_si256(q + 2)));
+                    s1 = _mm256_add_epi32(s1, _mm256_madd_epi16(r[3], _mm256_load_si256(q + 3)));
+                    s0 = _mm256_add_epi32(s0, _mm256_madd_epi16(r[4], _mm256_load_si256(q + 4)));
+                    sum[n] = _mm256_add_epi32(s0, s1);
+                }
+                avx2_store8_u8(out + j * cout, _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(avx2_hsum8_epi32(sum)), multiplier), bias));
+            }
+        }, src, dst);
+    }
+    // iterate over the source pixels, the channels of each of them are loaded once for its 2x2 output block,
+    // the blocks of `span` pixels are collected and written as two rows, with non-temporal stores for a large dst.
+    // kernels must be quantized by avx2_int8_deconv2x2_quantize
+    template <typename OUT, int cin, int cout, int span>
+    inline void deconv2x2_avx2_int8(const Image& src, Image& dst, const float* const kernels)
+    {
+        static_assert(cin == 8, "cin must be 8");
+
+        const bool nt = detail::nonTemporal(dst);
+
+        parallelFor(0, src.height(), [=](const int i) {
+            auto in = static_cast<const std::uint8_t*>(src.ptr(0, i));
+            OUT* const out[] = { static_cast<OUT*>(dst.ptr(0, i * 2)), static_cast<OUT*>(dst.ptr(0, i * 2 + 1)) };
+
+            alignas(32) OUT buffer[2][span * 2 * cout];
+
+            const int w = src.width();
+            for (int j = 0; j < w; j += span)
+            {
+                const int valid = w - j < span ? w - j : span;
+                for (int p = 0; p < valid; p++)
+                {
+                    __m256 r = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + (j + p) * cin))));
+                    for (int index = 0; index < 4; index++)
+                        for (int n = 0; n < cout; n++)
+                            buffer[index >> 1][(p * 2 + (index & 1)) * cout + n] = fromFloat<OUT>(avx2_hsum_ps(_mm256_mul_ps(r, _mm256_load_ps(kernels + (index * cout + n) * cin))));
+                }
+                for (int k = 0; k < 2; k++) avx2_stream(out[k] + j * 2 * cout, buffer[k], static_cast<int>(valid * 2 * cout * sizeof(OUT)), nt);
+            }
+            if (nt) _mm_sfence();
+        });
+    }
+
+    void conv3x3_1to8_avx2_int8(const Image& src, Image& dst, const float* kernels, const float* biases)
+    {
+        switch (src.type())
+        {
+        case Image::UInt8:
+            conv3x3_avx2_int8_cin1<std::uint8_t, 8>(src, dst, kernels, biases);
+            break;
+        case Image::UInt16:
+            conv3x3_avx2_int8_cin1<std::uint16_t, 8>(src, dst, kernels, biases);
+            break;
+        case Image::Float32:
+            conv3x3_avx2_int8_cin1<float, 8>(src, dst, kernels, biases);
+            break;
+        }
+    }
+    void conv3x3_8to8_avx2_int8(const Image& src, Image& dst, const float* kernels, const float* biases)
+    {
+        conv3x3_avx2_int8_block<8, 8>(src, dst, kernels, biases);
+    }
+    void deconv2x2_8to1_avx2_int8(const Image& src, Image& dst, const float* kernels)
+    {
+        switch (dst.type())
+        {
+        case Image::UInt8:
+            deconv2x2_avx2_int8<std::uint8_t, 8, 1, 16>(src, dst, kernels);
+            break;
+        case Image::UInt16:
+            deconv2x2_avx2_int8<std::uint16_t, 8, 1, 16>(src, dst, kernels);
+            break;
+        case Image::Float32:
+            deconv2x2_avx2_int8<float, 8, 1, 16>(src, dst, kernels);
+            break;
+        }
+    }
+
+    int conv3x3_1to8_avx2_int8_quantize(const float* kernels, const float* biases, float /*scaleIn*/, float scaleOut, float* packed, float* params)
+    {
+        if (packed) avx2_int8_cin1_quantize<8>(kernels, biases, scaleOut, packed, params);
+        return 9 * 8;
+    }
+    int conv3x3_8to8_avx2_int8_quantize(const float* kernels, const float* biases, float scaleIn, float scaleOut, float* packed, float* params)
+    {
+        if (packed) avx2_int8_block_quantize<8, 8>(kernels, biases, scaleIn, scaleOut, reinterpret_cast<std::int16_t*>(packed), params);
+        return 8 * 5 * 16 * sizeof(std::int16_t) / sizeof(float);
+    }
+    int deconv2x2_8to1_avx2_int8_quantize(const float* kernels, const float* /*biases*/, float scaleIn, float /*scaleOut*/, float* packed, float* /*params*/)
+    {
+        if (packed) avx2_int8_deconv2x2_quantize<8, 1>(kernels, scaleIn, packed);
+        return 4 * 1 * 8;
+    }
+}
@@ -0,0 +1,310 @@
+#include <cstdint>
+
+// GCC before 13 warns about the self-initialized placeholder vectors of _mm512_undefined_* in its own intrinsics, see GCC bug 105593
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ < 13
+#   pragma GCC diagnostic push
+#   pragma GCC diagnostic ignored "-Wuninitialized"
+#   pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#   include <immintrin.h>
+#   pragma GCC diagnostic pop
+#else
+#   include <immintrin.h>
+#endif
+
+#include "AC/Core/Image.hpp"
+#include "AC/Core/Util.hpp"
+
+namespace ac::core::cpu
+{
+    // [v0..v7, v0..v7]
+    inline static __m512 avx512_dup8_ps(const float* const v) noexcept
+    {
+        return _mm512_castpd_ps(_mm512_broadcast_f64x4(_mm256_castps_pd(_mm256_loadu_ps(v))));
+    }
+    // mask of the first `n` floats of a vector
+    inline static __mmask16 avx512_mask(const int n) noexcept
+    {
+        return n >= 16 ? static_cast<__mmask16>(0xffff) : static_cast<__mmask16>((1u << n) - 1);
+    }
+    // `t[k]` holds two 8-lane groups, v[2k] in its lower half and v[2k + 1] in its upper half,
+    // returns one vector of their 16 horizontal sums with hsum(v[n]) in lane 4 * (n % 4) + n / 4
+    inline static __m512 avx512_hsum16_ps_transposed(const __m512* const t) noexcept
+    {
+        __m512 u[4], w[2];
+        for (int m = 0; m < 4; m++)
+            u[m] = _mm512_add_ps(_mm512_shuffle_f32x4(t[2 * m], t[2 * m + 1], _MM_SHUFFLE(2, 0, 2, 0)), _mm512_shuffle_f32x4(t[2 * m], t[2 * m + 1], _MM_SHUFFLE(3, 1, 3, 1)));
+        for (int m = 0; m < 2; m++)
+            w[m] = _mm512_add_ps(_mm512_shuffle_ps(u[2 * m], u[2 * m + 1], _MM_SHUFFLE(1, 0, 1, 0)), _mm512_shuffle_ps(u[2 * m], u[2 * m + 1], _MM_SHUFFLE(3, 2, 3, 2)));
+        return _mm512_add_ps(_mm512_shuffle_ps(w[0], w[1], _MM_SHUFFLE(2, 0, 2, 0)), _mm512_shuffle_ps(w[0], w[1], _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+    // reduce 16 vectors to one vector of their horizontal sums, [hsum(v0), hsum(v1), ..., hsum(v15)]
+    inline static __m512 avx512_hsum16_ps(const __m512* const v) noexcept
+    {
+        __m512 t[8];
+        for (int k = 0; k < 8; k++)
+            t[k] = _mm512_add_ps(_mm512_shuffle_f32x4(v[2 * k], v[2 * k + 1], _MM_SHUFFLE(1, 0, 1, 0)), _mm512_shuffle_f32x4(v[2 * k], v[2 * k + 1], _MM_SHUFFLE(3, 2, 3, 2)));
+        return _mm512_permutexvar_ps(_mm512_setr_epi32(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15), avx512_hsum16_ps_transposed(t));
+    }
+    // store 16 floats with clamping and conversion, only the lanes in `mask`.
+    // if `nt`, all the lanes are stored with a non-temporal store when ptr is aligned to their size, a _mm_sfence is needed before they are read by another thread.
+    template <typename OUT>
+    inline static void avx512_store(OUT* const ptr, const __mmask16 mask, const __m512& v, const bool nt = false) noexcept
+    {
+        const bool stream = nt && mask == 0xffff && !(reinterpret_cast<std::uintptr_t>(ptr) & (16 * sizeof(OUT) - 1));
+        __m512 r = _mm512_min_ps(_mm512_max_ps(v, _mm512_setzero_ps()), _mm512_set1_ps(1.0f));
+        if constexpr (std::is_floating_point_v<OUT>)
+        {
+            if (stream) _mm512_stream_ps(ptr, r);
+            else _mm512_mask_storeu_ps(ptr, mask, r);
+        }
+        else
+        {
+            __m512i u = _mm512_cvttps_epi32(_mm512_add_ps(_mm512_mul_ps(r, _mm512_set1_ps(static_cast<float>(std::numeric_limits<OUT>::max()))), _mm512_set1_ps(0.5f)));
+            if constexpr (sizeof(OUT) == 1)
+            {
+                if (stream) _mm_stream_si128(reinterpret_cast<__m128i*>(ptr), _mm512_cvtusepi32_epi8(u));
+                else _mm512_mask_cvtusepi32_storeu_epi8(ptr, mask, u);
+            }
+            else
+            {
+                if (stream) _mm256_stream_si256(reinterpret_cast<__m256i*>(ptr), _mm512_cvtusepi32_epi16(u));
+                else _mm512_mask_cvtusepi32_storeu_epi16(ptr, mask, u);
+            }
+        }
+    }
+
+    // [9][cout] twice, the taps of one output channel are contiguous in the model
+    template <int cout>
+    inline static void avx512_cin1_pack(const float* const kernels, float* const packed) noexcept
+    {
+        for (int k = 0; k < 9; k++)
+            for (int n = 0; n < cout; n++) packed[k * 16 + n] = packed[k * 16 + cout + n] = kernels[n * 9 + k];
+    }
+    // [cout][3][2][16], the right tap of each row is padded with zeros
+    template <int cin, int cout>
+    inline static void avx512_block_pack(const float* const kernels, float* const packed) noexcept
+    {
+        for (int n = 0; n < cout; n++)
+            for (int y = 0; y < 3; y++)
+                for (int k = 0; k < 32; k++)
+                    packed[(n * 3 + y) * 32 + k] = k < 3 * cin ? kernels[n * cin * 9 + y * 3 * cin + k] : 0.0f;
+    }
+    // [4][cin] twice, the kernels of one position of the 2x2 output block for all the input channels
+    template <int cin>
+    inline static void avx512_deconv2x2_pack(const float* const kernels, float* const packed) noexcept
+    {
+        for (int index = 0; index < 4; index++)
+            for (int c = 0; c < cin; c++) packed[index * 16 + c] = packed[index * 16 + cin + c] = kernels[c * 4 + index];
+    }
+
+    // two horizontally adjacent pixels per iteration, each vector holds all the output channels of both of them
+    // kernels must be packed by avx512_cin1_pack
+    template <typename IN, int cout>
+    inline void conv3x3_avx512_cin1(const Image& src, Image& dst, const float* const kernels, const float* const biases)
+    {
+        static_assert(cout == 8, "cout must be 8");
+
+        int h = src.height();
+        int step = src.stride() / src.elementSize();
+        const float* const kptr = kernels;
+
+        filterRows([=](const int i, const int w, const void* const sptr, void* const dptr) {
+            auto in = static_cast<const IN*>(sptr);
+            auto out = static_cast<float*>(dptr);
+
+            const IN* rows[] = { i > 0 ? in - step : in, in, i < h - 1 ? in + step : in };
+
+            const __m512 bias = avx512_dup8_ps(biases);
+
+            for (int j = 0; j < w; j += 2)
+            {
+                // the second pixel repeats the first one at the end of an odd row
+                const int q = j + 1 < w ? j + 1 : j;
+                const int cols[2][3] = {
+                    { j > 0 ? j - 1 : 0, j, j + 1 < w ? j + 1 : w - 1 },
+                    { q > 0 ? q - 1 : 0, q, q + 1 < w ? q + 1 : w - 1 }
+                };
+
+                __m512 s0 = bias;
+                __m512 s1 = _mm512_setzero_ps();
+                __m512 s2 = _mm512_setzero_ps();
+                for (int y = 0; y < 3; y++)
+                {
+                    auto r = rows[y];
+                    __m512 r0 = _mm512_mask_blend_ps(0xff00, _mm512_set1_ps(toFloat<IN>(r[cols[0][0]])), _mm512_set1_ps(toFloat<IN>(r[cols[1][0]])));
+                    __m512 r1 = _mm512_mask_blend_ps(0xff00, _mm512_set1_ps(toFloat<IN>(r[cols[0][1]])), _mm512_set1_ps(toFloat<IN>(r[cols[1][1]])));
+                    __m512 r2 = _mm512_mask_blend_ps(0xff00, _mm512_set1_ps(toFloat<IN>(r[cols[0][2]])), _mm512_set1_ps(toFloat<IN>(r[cols[1][2]])));
+                    s0 = _mm512_fmadd_ps(r0, _mm512_load_ps(kptr + (y * 3 + 0) * 16), s0);
+                    s1 = _mm512_fmadd_ps(r1, _mm512_load_ps(kptr + (y * 3 + 1) * 16), s1);
+                    s2 = _mm512_fmadd_ps(r2, _mm512_load_ps(kptr + (y * 3 + 2) * 16), s2);
+                }
+                __m512 v = _mm512_max_ps(_mm512_add_ps(s0, _mm512_add_ps(s1, s2)), _mm512_setzero_ps());
+                _mm512_mask_storeu_ps(out + j * cout, avx512_mask((q - j + 1) * cout), v);
+            }
+        }, src, dst);
+    }
+    // two horizontally adjacent pixels per iteration. A vector holds two neighbouring input pixels of 8 channels, so a row of 3 taps is
+    // one full load of the left and middle taps and a masked load of the right one, the 16 horizontal sums of both pixels are reduced together.
+    // src must have a 1-pixel replicated border, so there is no clamping at the edges
+    // kernels must be packed by avx512_block_pack
+    template <int cin, int cout>
+    inline void conv3x3_avx512_block(const Image& src, Image& dst, const float* const kernels, const float* const biases)
+    {
+        static_assert(cin == 8 && cout == 8, "cin and cout must be 8");
+
+        int step = src.stride() / src.elementSize();
+        const float* const kptr = kernels;
+        // pixel -1 of each row starts on 64 bytes, as in the scratch images with a border of one pixel,
+        // so every pair of pixels starting at an odd index is a single aligned load
+        const bool aligned = !((reinterpret_cast<std::uintptr_t>(src.ptr()) - cin * sizeof(float)) & 63) && !(src.stride() & 63);
+
+        filterRows([=](const int /*i*/, const int w, const void* const sptr, void* const dptr) {
+            auto in = static_cast<const float*>(sptr);
+            auto out = static_cast<float*>(dptr);
+
+            const float* rows[] = { in - step, in, in + step };
+
+            const __m512 bias = avx512_dup8_ps(biases);
+
+            for (int j = 0; j < w; j += 2)
+            {
+                // the second pixel repeats the first one at the end of an odd row
+                const int q = j + 1 < w ? j + 1 : j;
+
+                __m512 a[2][3], b[2][3];
+                if (aligned && q > j)
+                {
+                    // pixels j - 1 to j + 2 in two aligned loads, the taps of the second pixel are shuffled out of them
+                    for (int y = 0; y < 3; y++)
+                    {
+                        const __m512 l = _mm512_load_ps(rows[y] + (j - 1) * cin), r = _mm512_load_ps(rows[y] + (j + 1) * cin);
+                        a[0][y] = l;
+                        b[0][y] = _mm512_maskz_mov_ps(0x00ff, r);
+                        a[1][y] = _mm512_shuffle_f32x4(l, r, _MM_SHUFFLE(1, 0, 3, 2));
+                        b[1][y] = _mm512_maskz_shuffle_f32x4(0x00ff, r, r, _MM_SHUFFLE(3, 2, 3, 2));
+                    }
+                }
+                else
+                {
+                    // the right taps are read with a mask, the 8 floats after them may be past the border
+                    for (int y = 0; y < 3; y++)
+                    {
+                        a[0][y] = _mm512_loadu_ps(rows[y] + (j - 1) * cin);
+                        b[0][y] = _mm512_maskz_loadu_ps(0x00ff, rows[y] + (j + 1) * cin);
+                        a[1][y] = _mm512_loadu_ps(rows[y] + (q - 1) * cin);
+                        b[1][y] = _mm512_maskz_loadu_ps(0x00ff, rows[y] + (q + 1) * cin);
+                    }
+                }
+
+                __m512 sum[2 * cout];
+                for (int n = 0; n < cout; n++)
+                {
+                    auto k = kptr + n * 3 * 32;
+                    for (int p = 0; p < 2; p++)
+                    {
+                        __m512 s = _mm512_mul_ps(a[p][0], _mm512_load_ps(k + 0));
+                        s = _mm512_fmadd_ps(b[p][0], _mm512_load_ps(k + 16), s);
+                        s = _mm512_fmadd_ps(a[p][1], _mm512_load_ps(k + 32), s);
+                        s = _mm512_fmadd_ps(b[p][1], _mm512_load_ps(k + 48), s);
+                        s = _mm512_fmadd_ps(a[p][2], _mm512_load_ps(k + 64), s);
+                        s = _mm512_fmadd_ps(b[p][2], _mm512_load_ps(k + 80), s);
+                        sum[p * cout + n] = s;
+                    }
+                }
+                __m512 v = _mm512_max_ps(_mm512_add_ps(avx512_hsum16_ps(sum), bias), _mm512_setzero_ps());
+                _mm512_mask_storeu_ps(out + j * cout, avx512_mask((q - j + 1) * cout), v);
+            }
+        }, src, dst);
+    }
+    // 8 source pixels, 16 destination pixels of both rows of their 2x2 blocks, per iteration. A vector holds two source pixels of 8 channels,
+    // it is loaded once and multiplied by the four kernels of the block, the 16 sums of the 8 products of each row come out of the same
+    // reduction as conv3x3_avx512_block. A large dst is written with non-temporal stores.
+    // kernels must be packed by avx512_deconv2x2_pack
+    template <typename OUT, int cin, int cout>
+    inline void deconv2x2_avx512_float(const Image& src, Image& dst, const float* const kernels)
+    {
+        static_assert(cin == 8 && cout == 1, "cin must be 8 and cout must be 1");
+
+        const bool nt = detail::nonTemporal(dst);
+
+        parallelFor(0, src.height(), [=](const int i) {
+            auto in = static_cast<const float*>(src.ptr(0, i));
+            OUT* const out[] = { static_cast<OUT*>(dst.ptr(0, i * 2)), static_cast<OUT*>(dst.ptr(0, i * 2 + 1)) };
+
+            const __m512 k[4] = { _mm512_load_ps(kernels + 0 * 16), _mm512_load_ps(kernels + 1 * 16), _mm512_load_ps(kernels + 2 * 16), _mm512_load_ps(kernels + 3 * 16) };
+            // dst pixel 4m + 2h + e of a row comes from the half h of the product of source pair m and kernel e of the row, see avx512_hsum16_ps_transposed
+            const __m512i order = _mm512_setr_epi32(0, 8, 4, 12, 1, 9, 5, 13, 2, 10, 6, 14, 3, 11, 7, 15);
+
+            const int w = src.width();
+            for (int j = 0; j < w; j += 8)
+            {
+                const int valid = w - j < 8 ? w - j : 8;
+
+                __m512 t[2][8];
+                for (int m = 0; m < 4; m++)
+                {
+                    int n = valid - 2 * m;
+                    __m512 r = _mm512_maskz_loadu_ps(avx512_mask((n < 0 ? 0 : n) * cin), in + (j + 2 * m) * cin);
+                    for (int y = 0; y < 2; y++)
+                    {
+                        t[y][2 * m + 0] = _mm512_mul_ps(r, k[y * 2 + 0]);
+                        t[y][2 * m + 1] = _mm512_mul_ps(r, k[y * 2 + 1]);
+                    }
+                }
+                for (int y = 0; y < 2; y++) avx512_store(out[y] + j * 2, avx512_mask(valid * 2), _mm512_permutexvar_ps(order, avx512_hsum16_ps_transposed(t[y])), nt);
+            }
+            if (nt) _mm_sfence();
+        });
+    }
+
+    void conv3x3_1to8_avx512(const Image& src, Image& dst, const float* kernels, const float* biases)
+    {
+        switch (src.type())
+        {
+        case Image::UInt8:
+            conv3x3_avx512_cin1<std::uint8_t, 8>(src, dst, kernels, biases);
+            break;
+        case Image::UInt16:
+            conv3x3_avx512_cin1<std::uint16_t, 8>(src, dst, kernels, biases);
+            break;
+        case Image::Float32:
+            conv3x3_avx512_cin1<float, 8>(src, dst, kernels, biases);
+            break;
+        }
+    }
+    void conv3x3_8to8_avx512(const Image& src, Image& dst, const float* kernels, const float* biases)
+    {
+        conv3x3_avx512_block<8, 8>(src, dst, kernels, biases);
+    }
+    void deconv2x2_8to1_avx512(const Image& src, Image& dst, const float* kernels)
+    {
+        switch (dst.type())
+        {
+        case Image::UInt8:
+            deconv2x2_avx512_float<std::uint8_t, 8, 1>(src, dst, kernels);
+            break;
+        case Image::UInt16:
+            deconv2x2_avx512_float<std::uint16_t, 8, 1>(src, dst, kernels);
+            break;
+        case Image::Float32:
+            deconv2x2_avx512_float<float, 8, 1>(src, dst, kernels);
+            break;
+        }
+    }
+
+    int conv3x3_1to8_avx512_pack(const float* kernels, float* packed)
+    {
+        if (packed) avx512_cin1_pack<8>(kernels, packed);
+        return 9 * 16;
+    }
+    int conv3x3_8to8_avx512_pack(const float* kernels, float* packed)
+    {
+        if (packed) avx512_block_pack<8, 8>(kernels, packed);
+        return 8 * 3 * 2 * 16;
+    }
+    int deconv2x2_8to1_avx512_pack(const float* kernels, float* packed)
+    {
+        if (packed) avx512_deconv2x2_pack<8>(kernels, packed);
+        return 4 * 2 * 8;
+    }
+}
@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
 #include <xmmintrin.h>
 
 #include "AC/Core/Image.hpp"
@@ -11,6 +15,57 @@ namespace ac::core::cpu
         __m128 v32 = _mm_add_ss(v64, _mm_shuffle_ps(v64, v64, _MM_SHUFFLE(3, 3, 1, 1)));
         return _mm_cvtss_f32(v32);
     }
+    // reduce 4 vectors to one vector of their horizontal sums, [hsum(v0), hsum(v1), hsum(v2), hsum(v3)]
+    inline static __m128 sse_hsum4_ps(const __m128* const v) noexcept
+    {
+        __m128 v0 = v[0], v1 = v[1], v2 = v[2], v3 = v[3];
+        _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+        return _mm_add_ps(_mm_add_ps(v0, v1), _mm_add_ps(v2, v3));
+    }
+    // copy `size` bytes from the 16-byte aligned `src` to `dst`, its 16-byte chunks are written with non-temporal stores if `nt` and `dst` is 16-byte aligned,
+    // a _mm_sfence is needed before they are read by another thread.
+    inline static void sse_stream(void* const dst, const void* const src, const int size, const bool nt) noexcept
+    {
+        if (nt && !(reinterpret_cast<std::uintptr_t>(dst) & 15))
+        {
+            auto d = static_cast<float*>(dst);
+            auto s = static_cast<const float*>(src);
+            int i = 0;
+            for (; i + 16 <= size; i += 16) _mm_stream_ps(d + i / 4, _mm_load_ps(s + i / 4));
+            if (i < size) std::memcpy(d + i / 4, s + i / 4, size - i);
+        }
+        else std::memcpy(dst, src, size);
+    }
+    // write the 2x2 output blocks of `n` source pixels starting at `j` of a row, `buffer` holds the two output rows of them
+    template <typename OUT, int size>
+    inline static void sse_store_blocks(OUT* const* const out, const OUT (&buffer)[2][size], const int j, const int n, const int cout, const bool nt) noexcept
+    {
+        for (int k = 0; k < 2; k++) sse_stream(out[k] + j * 2 * cout, buffer[k], static_cast<int>(n * 2 * cout * sizeof(OUT)), nt);
+    }
+    // transpose conv3x3 kernels from [cout][9][cin] to [9][cin][cout], so that all the output channels of one input value are contiguous
+    template <int cin, int cout>
+    inline static void sse_broadcast_pack(const float* const kernels, float* const packed) noexcept
+    {
+        for (int n = 0; n < cout; n++)
+            for (int k = 0; k < 9 * cin; k++)
+                packed[k * cout + n] = kernels[n * cin * 9 + k];
+    }
+    // pad the 9 taps of each output channel of a cin == 1 conv3x3 to 12, so that both vectors of them are aligned
+    template <int cout>
+    inline static void sse_cin1_pack(const float* const kernels, float* const packed) noexcept
+    {
+        for (int n = 0; n < cout; n++)
+            for (int k = 0; k < 12; k++) packed[n * 12 + k] = k < 9 ? kernels[n * 9 + k] : 0.0f;
+    }
+    // transpose deconv2x2 kernels from [cin][4][cout] to [4][cout][cin], cin padded to a multiple of 4 with zeros
+    template <int cin, int cout>
+    inline static void sse_deconv2x2_pack(const float* const kernels, float* const packed) noexcept
+    {
+        constexpr int cinp = align(cin, 4);
+        for (int index = 0; index < 4; index++)
+            for (int n = 0; n < cout; n++)
+                for (int c = 0; c < cinp; c++) packed[(index * cout + n) * cinp + c] = c < cin ? kernels[c * cout * 4 + cout * index + n] : 0.0f;
+    }
 
     template <typename OUT, int cin, int cout>
     inline void conv3x3_sse_float(const Image& src, Image& dst, const float* const kernels, const float* const biases)
@@ -136,6 +191,78 @@ namespace ac::core::cpu
             }
         }, src, dst);
     }
+    // compute `block` horizontally adjacent pixels of the row `in` per iteration, the 3x(block+2) input columns are loaded once and shared by all of them,
+    // `store(j, v)` is called with the `cout / 4` vectors of outputs of each pixel `j` after relu
+    // the row must have a 1-pixel replicated border, so there is no clamping at the edges
+    // kernels must be 16-byte aligned
+    template <int cin, int cout, int block, typename F>
+    inline void conv3x3_sse_block_row(const float* const in, const int step, const int w, const float* const kernels, const float* const biases, F&& store)
+    {
+        constexpr int vstep = 4;
+        constexpr int count = cin / vstep;
+        static_assert(cin % vstep == 0 && cout % vstep == 0, "cin and cout must be multiples of 4");
+
+        const float* rows[] = { in - step, in, in + step };
+
+        for (int j = 0; j < w; j += block)
+        {
+            const int valid = w - j < block ? w - j : block;
+
+            __m128 r[3][block + 2][count];
+            for (int x = 0; x < block + 2; x++)
+            {
+                // only the last block of a row may go past the border
+                auto col = (j + x - 1 < w ? j + x - 1 : w) * cin;
+                for (int y = 0; y < 3; y++)
+                    for (int idx = 0; idx < count; idx++) r[y][x][idx] = _mm_loadu_ps(rows[y] + col + idx * vstep);
+            }
+
+            for (int p = 0; p < valid; p++)
+            {
+                __m128 v[cout / vstep];
+                for (int m = 0; m < cout; m += vstep)
+                {
+                    __m128 sum[vstep];
+                    for (int n = 0; n < vstep; n++)
+                    {
+                        __m128 s0 = _mm_setzero_ps();
+                        __m128 s1 = _mm_setzero_ps();
+                        __m128 s2 = _mm_setzero_ps();
+                        for (int idx = 0; idx < count; idx++)
+                        {
+                            const float* kptr = kernels + (m + n) * cin * 9 + idx * vstep;
+                            s0 = _mm_add_ps(_mm_mul_ps(r[0][p + 0][idx], _mm_load_ps(kptr + cin * 0)), s0);
+                            s1 = _mm_add_ps(_mm_mul_ps(r[0][p + 1][idx], _mm_load_ps(kptr + cin * 1)), s1);
+                            s2 = _mm_add_ps(_mm_mul_ps(r[0][p + 2][idx], _mm_load_ps(kptr + cin * 2)), s2);
+                            s0 = _mm_add_ps(_mm_mul_ps(r[1][p + 0][idx], _mm_load_ps(kptr + cin * 3)), s0);
+                            s1 = _mm_add_ps(_mm_mul_ps(r[1][p + 1][idx], _mm_load_ps(kptr + cin * 4)), s1);
+                            s2 = _mm_add_ps(_mm_mul_ps(r[1][p + 2][idx], _mm_load_ps(kptr + cin * 5)), s2);
+                            s0 = _mm_add_ps(_mm_mul_ps(r[2][p + 0][idx], _mm_load_ps(kptr + cin * 6)), s0);
+                            s1 = _mm_add_ps(_mm_mul_ps(r[2][p + 1][idx], _mm_load_ps(kptr + cin * 7)), s1);
+                            s2 = _mm_add_ps(_mm_mul_ps(r[2][p + 2][idx], _mm_load_ps(kptr + cin * 8)), s2);
+                        }
+                        sum[n] = _mm_add_ps(s0, _mm_add_ps(s1, s2));
+                    }
+                    v[m / vstep] = _mm_max_ps(_mm_add_ps(sse_hsum4_ps(sum), _mm_loadu_ps(biases + m)), _mm_setzero_ps());
+                }
+                store(j + p, v);
+            }
+        }
+    }
+    // src must have a 1-pixel replicated border
+    template <int cin, int cout, int block>
+    inline void conv3x3_sse_block(const Image& src, Image& dst, const float* const kernels, const float* const biases)
+    {
+        int step = src.stride() / src.elementSize();
+
+        filterRows([=](const int /*i*/, const int w, const void* const sptr, void* const dptr) {
+            auto out = static_cast<float*>(dptr);
+            conv3x3_sse_block_row<cin, cout, block>(static_cast<const float*>(sptr), step, w, kernels, biases, [=](const int j, const __m128* const v) {
+                for (int m = 0; m < cout; m += 4) _mm_storeu_ps(out + j * cout + m, v[m / 4]);
+            });
+        }, src, dst);
+    }
+    // kernels must be packed by sse_cin1_pack
     template <typename IN, typename OUT, int cout>
     inline void conv3x3_sse_cin1(const Image& src, Image& dst, const float* const kernels, const float* const biases)
     {
@@ -169,50 +296,151 @@ namespace ac::core::cpu
 
             for (int n = 0; n < cout; n++)
             {
-                __m128 k0 = _mm_loadu_ps(kernels + n * 9 + 0);
-                __m128 k4 = _mm_loadu_ps(kernels + n * 9 + 4);
+                __m128 k0 = _mm_load_ps(kernels + n * 12 + 0);
+                __m128 k4 = _mm_load_ps(kernels + n * 12 + 4);
                 auto sum = sse_hsum_ps(_mm_add_ps(_mm_mul_ps(r0, k0), _mm_mul_ps(r4, k4)));
-                auto k8 = *(kernels + n * 9 + 8);
+                auto k8 = *(kernels + n * 12 + 8);
                 out[n] = relu<OUT>(sum + k8 * r8 + biases[n]);
             }
         }, src, dst);
     }
-    template <typename OUT, int cin, int cout>
+    // iterate over the source pixels, the channels of each of them are loaded once for its 2x2 output block,
+    // the blocks of `span` pixels are collected and written as two rows, with non-temporal stores for a large dst.
+    // kernels must be packed by sse_deconv2x2_pack
+    template <typename OUT, int cin, int cout, int span>
     inline void deconv2x2_sse_float(const Image& src, Image& dst, const float* const kernels)
     {
-        filter([=](const int i, const int j, const void* const sptr, void* const dptr) {
-            auto in = static_cast<const float*>(sptr);
-            auto out = static_cast<OUT*>(dptr);
+        const bool nt = detail::nonTemporal(dst);
 
-            const int index = ((i & 1) << 1) + (j & 1);
+        parallelFor(0, src.height(), [=](const int i) {
+            auto in = static_cast<const float*>(src.ptr(0, i));
+            OUT* const out[] = { static_cast<OUT*>(dst.ptr(0, i * 2)), static_cast<OUT*>(dst.ptr(0, i * 2 + 1)) };
 
             constexpr int vstep = 4;
             constexpr int count = cin / vstep;
             constexpr int remain = cin % vstep;
-            constexpr int nstep = 4 * cout;
+            constexpr int cinp = align(cin, vstep);
 
-            __m128 r[count + (remain ? 1 : 0)] = {};
-            for (int idx = 0; idx < count; idx++) r[idx] = _mm_loadu_ps(in + idx * vstep);
+            alignas(16) OUT buffer[2][span * 2 * cout];
 
-            if constexpr (remain) r[count] = _mm_set_ps(0.0f, remain > 2 ? (in + count * vstep)[2] : 0.0f, remain > 1 ? (in + count * vstep)[1] : 0.0f, (in + count * vstep)[0]);
-            for (int n = 0; n < cout; n++)
+            const int w = src.width();
+            for (int j = 0; j < w; j += span)
             {
-                float sum = 0.0f;
-                __m128 k[count + (remain ? 1 : 0)] = {};
-                for (int idx = 0; idx < count; idx++)
+                const int valid = w - j < span ? w - j : span;
+                for (int p = 0; p < valid; p++)
                 {
-                    auto kptr = kernels + idx * vstep * cout * 4 + cout * index;
-                    k[idx] = _mm_set_ps(kptr[3 * nstep + n], kptr[2 * nstep + n], kptr[1 * nstep + n], kptr[0 * nstep + n]);
-                    sum += sse_hsum_ps(_mm_mul_ps(r[idx], k[idx]));
+                    auto ptr = in + (j + p) * cin;
+
+                    __m128 r[count + (remain ? 1 : 0)] = {};
+                    for (int idx = 0; idx < count; idx++) r[idx] = _mm_loadu_ps(ptr + idx * vstep);
+
+                    if constexpr (remain) r[count] = _mm_set_ps(0.0f, remain > 2 ? (ptr + count * vstep)[2] : 0.0f, remain > 1 ? (ptr + count * vstep)[1] : 0.0f, (ptr + count * vstep)[0]);
+                    for (int index = 0; index < 4; index++)
+                        for (int n = 0; n < cout; n++)
+                        {
+                            auto kptr = kernels + (index * cout + n) * cinp;
+                            float sum = 0.0f;
+                            for (int idx = 0; idx < count + (remain ? 1 : 0); idx++) sum += sse_hsum_ps(_mm_mul_ps(r[idx], _mm_load_ps(kptr + idx * vstep)));
+                            buffer[index >> 1][(p * 2 + (index & 1)) * cout + n] = fromFloat<OUT>(sum);
+                        }
                 }
-                if constexpr (remain)
+                sse_store_blocks(out, buffer, j, valid, cout, nt);
+            }
+            if (nt) _mm_sfence();
+        });
+    }
+    // conv3x3_sse_block followed by deconv2x2_sse_float with cout == 1, the 2x2 output block of each pixel is computed as soon as the pixel is,
+    // they are written every `span` pixels as deconv2x2_sse_float does.
+    // src must have a 1-pixel replicated border, dst is twice the size of src, deconvKernels must be packed by sse_deconv2x2_pack
+    template <typename OUT, int cin, int block, int span>
+    inline void conv3x3_deconv2x2_sse(const Image& src, Image& dst, const float* const kernels, const float* const biases, const float* const deconvKernels)
+    {
+        constexpr int vstep = 4;
+        constexpr int count = cin / vstep;
+
+        int step = src.stride() / src.elementSize();
+        const bool nt = detail::nonTemporal(dst);
+
+        parallelFor(0, src.height(), [=](const int i) {
+            OUT* const out[] = { static_cast<OUT*>(dst.ptr(0, i * 2)), static_cast<OUT*>(dst.ptr(0, i * 2 + 1)) };
+            alignas(16) OUT buffer[2][span * 2];
+            const int w = src.width();
+            conv3x3_sse_block_row<cin, cin, block>(static_cast<const float*>(src.ptr(0, i)), step, w, kernels, biases, [&](const int j, const __m128* const v) {
+                const int p = j % span;
+                for (int index = 0; index < 4; index++)
+                {
+                    float sum = 0.0f;
+                    for (int idx = 0; idx < count; idx++) sum += sse_hsum_ps(_mm_mul_ps(v[idx], _mm_load_ps(deconvKernels + index * cin + idx * vstep)));
+                    buffer[index >> 1][p * 2 + (index & 1)] = fromFloat<OUT>(sum);
+                }
+                if (p == span - 1 || j == w - 1) sse_store_blocks(out, buffer, j - p, p + 1, 1, nt);
+            });
+            if (nt) _mm_sfence();
+        });
+    }
+
+    // kernels must be packed by sse_broadcast_pack
+    template <typename IN, int cin, int cout>
+    inline void conv3x3_sse_broadcast(const Image& src, Image& dst, const float* const kernels, const float* const biases)
+    {
+        constexpr int vstep = 4;
+        constexpr int count = cout / vstep;
+        static_assert(cout % vstep == 0, "cout must be a multiple of 4");
+
+        int w = src.width(), h = src.height();
+        int step = src.stride() / src.elementSize();
+
+        const float* const kptr = kernels;
+
+        filter([=](const int i, const int j, const void* const sptr, void* const dptr) {
+            auto in = static_cast<const IN*>(sptr);
+            auto out = static_cast<float*>(dptr);
+
+            auto sp = i < h - 1 ? +step : 0;
+            auto sn = i > 0 ? -step : 0;
+            auto cp = j < w - 1 ? +cin : 0;
+            auto cn = j > 0 ? -cin : 0;
+
+            auto tl = in + sn + cn, tc = in + sn, tr = in + sn + cp;
+            auto ml = in + cn, mc = in, mr = in + cp;
+            auto bl = in + sp + cn, bc = in + sp, br = in + sp + cp;
+
+            __m128 s0[count] = {};
+            __m128 s1[count] = {};
+            __m128 s2[count] = {};
+
+            for (int idx = 0; idx < count; idx++) s0[idx] = _mm_loadu_ps(biases + idx * vstep);
+
+            for (int c = 0; c < cin; c++)
+            {
+                __m128 r0 = _mm_set1_ps(toFloat<IN>(tl[c]));
+                __m128 r1 = _mm_set1_ps(toFloat<IN>(tc[c]));
+                __m128 r2 = _mm_set1_ps(toFloat<IN>(tr[c]));
+                __m128 r3 = _mm_set1_ps(toFloat<IN>(ml[c]));
+                __m128 r4 = _mm_set1_ps(toFloat<IN>(mc[c]));
+                __m128 r5 = _mm_set1_ps(toFloat<IN>(mr[c]));
+                __m128 r6 = _mm_set1_ps(toFloat<IN>(bl[c]));
+                __m128 r7 = _mm_set1_ps(toFloat<IN>(bc[c]));
+                __m128 r8 = _mm_set1_ps(toFloat<IN>(br[c]));
+
+                for (int idx = 0; idx < count; idx++)
                 {
-                    auto kptr = kernels + count * vstep * cout * 4 + cout * index;
-                    k[count] = _mm_set_ps(0.0f, remain > 2 ? kptr[2 * nstep + n] : 0.0f, remain > 1 ? kptr[1 * nstep + n] : 0.0f, kptr[0 * nstep + n]);
-                    sum += sse_hsum_ps(_mm_mul_ps(r[count], k[count]));
+                    auto k = kptr + c * cout + idx * vstep;
+
+                    s0[idx] = _mm_add_ps(s0[idx], _mm_mul_ps(r0, _mm_load_ps(k + 0 * cin * cout)));
+                    s1[idx] = _mm_add_ps(s1[idx], _mm_mul_ps(r1, _mm_load_ps(k + 1 * cin * cout)));
+                    s2[idx] = _mm_add_ps(s2[idx], _mm_mul_ps(r2, _mm_load_ps(k + 2 * cin * cout)));
+                    s0[idx] = _mm_add_ps(s0[idx], _mm_mul_ps(r3, _mm_load_ps(k + 3 * cin * cout)));
+                    s1[idx] = _mm_add_ps(s1[idx], _mm_mul_ps(r4, _mm_load_ps(k + 4 * cin * cout)));
+                    s2[idx] = _mm_add_ps(s2[idx], _mm_mul_ps(r5, _mm_load_ps(k + 5 * cin * cout)));
+                    s0[idx] = _mm_add_ps(s0[idx], _mm_mul_ps(r6, _mm_load_ps(k + 6 * cin * cout)));
+                    s1[idx] = _mm_add_ps(s1[idx], _mm_mul_ps(r7, _mm_load_ps(k + 7 * cin * cout)));
+                    s2[idx] = _mm_add_ps(s2[idx], _mm_mul_ps(r8, _mm_load_ps(k + 8 * cin * cout)));
                 }
-                out[n] = fromFloat<OUT>(sum);
             }
+
+            for (int idx = 0; idx < count; idx++)
+                _mm_storeu_ps(out + idx * vstep, _mm_max_ps(_mm_add_ps(s0[idx], _mm_add_ps(s1[idx], s2[idx])), _mm_setzero_ps()));
         }, src, dst);
     }
 
@@ -233,21 +461,81 @@ namespace ac::core::cpu
     }
     void conv3x3_8to8_sse(const Image& src, Image& dst, const float* kernels, const float* biases)
     {
-        conv3x3_sse_float<float, 8, 8>(src, dst, kernels, biases);
+        conv3x3_sse_block<8, 8, 4>(src, dst, kernels, biases);
     }
     void deconv2x2_8to1_sse(const Image& src, Image& dst, const float* kernels)
     {
         switch (dst.type())
         {
         case Image::UInt8:
-            deconv2x2_sse_float<std::uint8_t, 8, 1>(src, dst, kernels);
+            deconv2x2_sse_float<std::uint8_t, 8, 1, 8>(src, dst, kernels);
+            break;
+        case Image::UInt16:
+            deconv2x2_sse_float<std::uint16_t, 8, 1, 8>(src, dst, kernels);
+            break;
+        case Image::Float32:
+            deconv2x2_sse_float<float, 8, 1, 8>(src, dst, kernels);
+            break;
+        }
+    }
+    void conv3x3_8to8_deconv2x2_8to1_sse(const Image& src, Image& dst, const float* kernels, const float* biases, const float* deconvKernels)
+    {
+        switch (dst.type())
+        {
+        case Image::UInt8:
+            conv3x3_deconv2x2_sse<std::uint8_t, 8, 4, 8>(src, dst, kernels, biases, deconvKernels);
             break;
         case Image::UInt16:
-            deconv2x2_sse_float<std::uint16_t, 8, 1>(src, dst, kernels);
+            conv3x3_deconv2x2_sse<std::uint16_t, 8, 4, 8>(src, dst, kernels, biases, deconvKernels);
             break;
         case Image::Float32:
-            deconv2x2_sse_float<float, 8, 1>(src, dst, kernels);
+            conv3x3_deconv2x2_sse<float, 8, 4, 8>(src, dst, kernels, biases, deconvKernels);
             break;
         }
     }
+    void conv3x3_1to8_sse_broadcast(const Image& src, Image& dst, const float* kernels, const float* biases)
+    {
+        switch (src.type())
+        {
+        case Image::UInt8:
+            conv3x3_sse_broadcast<std::uint8_t, 1, 8>(src, dst, kernels, biases);
+            break;
+        case Image::UInt16:
+            conv3x3_sse_broadcast<std::uint16_t, 1, 8>(src, dst, kernels, biases);
+            break;
+        case Image::Float32:
+            conv3x3_sse_broadcast<float, 1, 8>(src, dst, kernels, biases);
+            break;
+        }
+    }
+    void conv3x3_8to8_sse_broadcast(const Image& src, Image& dst, const float* kernels, const float* biases)
+    {
+        conv3x3_sse_broadcast<float, 8, 8>(src, dst, kernels, biases);
+    }
+
+    int conv3x3_1to8_sse_pack(const float* kernels, float* packed)
+    {
+        if (packed) sse_cin1_pack<8>(kernels, packed);
+        return 8 * 12;
+    }
+    int conv3x3_8to8_sse_pack(const float* kernels, float* packed)
+    {
+        if (packed) std::copy_n(kernels, 8 * 9 * 8, packed);
+        return 8 * 9 * 8;
+    }
+    int deconv2x2_8to1_sse_pack(const float* kernels, float* packed)
+    {
+        if (packed) sse_deconv2x2_pack<8, 1>(kernels, packed);
+        return 4 * 1 * 8;
+    }
+    int conv3x3_1to8_sse_broadcast_pack(const float* kernels, float* packed)
+    {
+        if (packed) sse_broadcast_pack<1, 8>(kernels, packed);
+        return 9 * 1 * 8;
+    }
+    int conv3x3_8to8_sse_broadcast_pack(const float* kernels, float* packed)
+    {
+        if (packed) sse_broadcast_pack<8, 8>(kernels, packed);
+        return 9 * 8 * 8;
+    }
 }
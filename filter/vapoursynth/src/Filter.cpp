@@ -114,6 +114,8 @@ static void VS_CC create(const VSMap* in, VSMap* out, void* /*userData*/, VSCore
         return ac::core::Processor::create<ac::core::Processor::CPU>(device, model);
     }();
     if (!data->processor->ok()) SET_ERROR(data->processor->error());
+    // fmParallel already runs frames in parallel
+    data->processor->setExecutionPolicy(ac::core::Processor::ExecutionSerial);
 
     VSFilterDependency deps[] = { {node, rpGeneral} };
     vsapi->createVideoFilter(out, "Upscale", &data->vi, filter, destory, fmParallel, deps, 1, data, core);
@@ -1,7 +1,8 @@
+#include <algorithm>
 #include <atomic>
+#include <memory>
 
 #include "AC/Core.hpp"
-#include "AC/Util/ThreadPool.hpp"
 #include "AC/Util/Stopwatch.hpp"
 #include "AC/Util/Defer.hpp"
 #ifdef AC_CLI_ENABLE_VIDEO
@@ -111,11 +112,16 @@ void Upscaler::start(const QList<QSharedPointer<TaskData>>& taskList)
             videoTaskList << task;
     }
 
-    static auto threads = ac::util::ThreadPool::hardwareThreads();
-    static ac::util::ThreadPool pool{ dptr->processorType == ac::core::Processor::CPU ? threads / 4 + 1 : threads / 2 + 1 };
-
 #   ifdef AC_CLI_ENABLE_VIDEO
-        pool.exec([=](){
+        if (!videoTaskList.empty()) ac::core::runtime::submit([=](){
+            // frames are already processed in parallel, so videos get their own cpu processor with serial kernels
+            auto processor = dptr->processor;
+            if (dptr->processorType == ac::core::Processor::CPU)
+            {
+                processor = detail::createProcessor(dptr->processorType, dptr->device, dptr->model);
+                processor->setExecutionPolicy(ac::core::Processor::ExecutionSerial);
+            }
+
             auto decoder =  gConfig.video.decoder.toLocal8Bit();
             auto format =  gConfig.video.format.toLocal8Bit();
             auto encoder =  gConfig.video.encoder.toLocal8Bit();
@@ -164,7 +170,7 @@ void Upscaler::start(const QList<QSharedPointer<TaskData>>& taskList)
                         dptr->factor,
                         info.fps * info.duration,
                         this,
-                        dptr->processor
+                        processor
                     };
                     ac::util::Stopwatch stopwatch{};
                     ac::video::filter(pipeline, [](ac::video::Frame& src, ac::video::Frame& dst, void* userdata) -> bool {
@@ -188,12 +194,12 @@ void Upscaler::start(const QList<QSharedPointer<TaskData>>& taskList)
                     }, &data, ac::video::FILTER_AUTO);
                     stopwatch.stop();
                     pipeline.close();
-                    if (!dptr->processor->ok()) gLogger.error() << dptr->processor->error();
-                    gLogger.info() << task->path.input <<": Finished in " << stopwatch.elapsed() << "s [" << gConfig.upscaler.processor << ' ' << dptr->processor->name() << ']';
+                    if (!processor->ok()) gLogger.error() << processor->error();
+                    gLogger.info() << task->path.input <<": Finished in " << stopwatch.elapsed() << "s [" << gConfig.upscaler.processor << ' ' << processor->name() << ']';
                     gLogger.info() << "Save video to " << task->path.output;
                 }
                 emit progress(100);
-                emit task->finished(!dptr->stopFlag && dptr->processor->ok());
+                emit task->finished(!dptr->stopFlag && processor->ok());
             }
         });
 #   else
@@ -205,39 +211,44 @@ void Upscaler::start(const QList<QSharedPointer<TaskData>>& taskList)
         }
 #   endif
 
-    for (auto&& task : imageTaskList)
-    {
-        pool.exec([=](){
-            ac::util::Defer defer([&]() { if (--dptr->total == 0) emit stopped(); });
-            if (!dptr->stopFlag)
+    auto processImage = [=](const QSharedPointer<TaskData>& task){
+        ac::util::Defer defer([&]() { if (--dptr->total == 0) emit stopped(); });
+        if (!dptr->stopFlag)
+        {
+            auto src = ac::core::imread(task->path.input.toLocal8Bit(), ac::core::IMREAD_UNCHANGED);
+            if (!src.empty())
+                gLogger.info() << "Load image from " << task->path.input;
+            else
             {
-                auto src = ac::core::imread(task->path.input.toLocal8Bit(), ac::core::IMREAD_UNCHANGED);
-                if (!src.empty())
-                    gLogger.info() << "Load image from " << task->path.input;
-                else
-                {
-                    gLogger.error() << "Failed to load image from " << task->path.input;
-                    emit task->finished(false);
-                    return;
-                }
+                gLogger.error() << "Failed to load image from " << task->path.input;
+                emit task->finished(false);
+                return;
+            }
 
-                ac::util::Stopwatch stopwatch{};
-                auto dst = dptr->processor->process(src, dptr->factor);
-                stopwatch.stop();
-                if (!dptr->processor->ok()) gLogger.error() << dptr->processor->error();
-                gLogger.info() << task->path.input <<": Finished in " << stopwatch.elapsed() << "s [" << gConfig.upscaler.processor << ' ' << dptr->processor->name() << ']';
+            ac::util::Stopwatch stopwatch{};
+            auto dst = dptr->processor->process(src, dptr->factor);
+            stopwatch.stop();
+            if (!dptr->processor->ok()) gLogger.error() << dptr->processor->error();
+            gLogger.info() << task->path.input <<": Finished in " << stopwatch.elapsed() << "s [" << gConfig.upscaler.processor << ' ' << dptr->processor->name() << ']';
 
-                if (ac::core::imwrite(task->path.output.toLocal8Bit(), dst)) gLogger.info() << "Save image to " << task->path.output;
-                else
-                {
-                    gLogger.error() << "Failed to save image to " << task->path.output;
-                    emit task->finished(false);
-                    return;
-                }
+            if (ac::core::imwrite(task->path.output.toLocal8Bit(), dst)) gLogger.info() << "Save image to " << task->path.output;
+            else
+            {
+                gLogger.error() << "Failed to save image to " << task->path.output;
+                emit task->finished(false);
+                return;
             }
-            emit task->finished(!dptr->stopFlag && dptr->processor->ok());
+        }
+        emit task->finished(!dptr->stopFlag && dptr->processor->ok());
+    };
+    // images are processed in a few lanes on the compute threads, each lane takes the next image until all are done
+    auto threads = ac::core::runtime::threads();
+    auto lanes = std::min(static_cast<int>(imageTaskList.size()), dptr->processorType == ac::core::Processor::CPU ? threads / 4 + 1 : threads / 2 + 1);
+    auto next = std::make_shared<std::atomic_int>(0);
+    for (int i = 0; i < lanes; i++)
+        ac::core::runtime::submit([=](){
+            for (auto idx = (*next)++; idx < imageTaskList.size(); idx = (*next)++) processImage(imageTaskList[idx]);
         });
-    }
 }
 void Upscaler::stop()
 {
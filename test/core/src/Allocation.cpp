@@ -0,0 +1,72 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "AC/Core.hpp"
+
+#include "Archs.hpp"
+
+// frames before the check, enough for every compute thread to have run a part of a frame
+constexpr int WarmupFrames = 8;
+constexpr int Frames = 4;
+
+// once warmed up, a frame into a preallocated `dst` must not allocate anything, and a frame without one only its result
+static bool check(ac::core::Processor& processor, const int w, const int h, const int c, const double factor)
+{
+    ac::core::Image src{ w, h, c, ac::core::Image::UInt8 };
+    for (int i = 0; i < h; i++)
+        for (int j = 0; j < w * c; j++) src.line(i)[j] = static_cast<std::uint8_t>(i * 7 + j * 13);
+
+    auto dst = processor.process(src, factor);
+    for (int i = 0; i < WarmupFrames; i++) processor.process(src, dst, factor);
+
+    auto count = ac::core::detail::allocations();
+    for (int i = 0; i < Frames; i++) processor.process(src, dst, factor);
+    auto preallocated = ac::core::detail::allocations() - count;
+
+    count = ac::core::detail::allocations();
+    for (int i = 0; i < Frames; i++) processor.process(src, factor);
+    auto fresh = ac::core::detail::allocations() - count;
+
+    bool ok = preallocated == 0 && fresh == Frames;
+    std::printf("[%s] %s %dx%dx%d x%.2lf: %zu allocations into dst, %zu without dst in %d frames\n", ok ? "PASS" : "FAIL", processor.name(), w, h, c, factor, preallocated, fresh, Frames);
+    return ok;
+}
+
+// create() keeps the buffer of an image if the new shape fits and no other image shares it
+static bool checkCreate()
+{
+    ac::core::Image image{ 160, 120, 3, ac::core::Image::UInt8 };
+    auto ptr = image.ptr();
+    auto count = ac::core::detail::allocations();
+    image.create(120, 160, 1, ac::core::Image::UInt16);
+    bool ok = image.ptr() == ptr && ac::core::detail::allocations() == count;
+
+    ac::core::Image shared = image;
+    image.create(16, 16, 1, ac::core::Image::UInt8);
+    ok = ok && image.ptr() != shared.ptr();
+
+    std::printf("[%s] create\n", ok ? "PASS" : "FAIL");
+    return ok;
+}
+
+int main()
+{
+    bool ok = checkCreate();
+    const int policies[] = { ac::core::Processor::ExecutionParallel, ac::core::Processor::ExecutionSerial };
+    const int channels[] = { 1, 3, 4 };
+    for (auto&& arch : ac::test::archs())
+        for (auto policy : policies)
+        {
+            auto processor = ac::core::Processor::create<ac::core::Processor::CPU>(arch.idx, ac::core::model::ACNet{ ac::core::model::ACNet::Variant::HDN0 });
+            processor->setExecutionPolicy(policy);
+            for (auto c : channels)
+            {
+                ok = check(*processor, 160, 120, c, 2.0) && ok;
+                ok = check(*processor, 160, 120, c, 1.5) && ok;
+                ok = check(*processor, 160, 120, c, 4.0) && ok;
+                ok = check(*processor, 640, 480, c, 2.0) && ok;
+            }
+        }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+#ifndef AC_TEST_CORE_ARCHS_HPP
+#define AC_TEST_CORE_ARCHS_HPP
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "AC/Core.hpp"
+#include "AC/Core/Dispatch.hpp"
+
+namespace ac::test
+{
+    struct Arch
+    {
+        int idx;
+        std::string name;
+    };
+
+    // whether the CPU running the test can run the arch called `name`.
+    inline bool supported(const std::string& name) noexcept
+    {
+        namespace dispatch = ac::core::cpu::dispatch;
+
+        if (name.compare(0, 3, "SSE") == 0) return dispatch::supportSSE();
+        if (name == "AVX_FP16") return dispatch::supportAVX() && dispatch::supportFMA() && dispatch::supportF16C();
+        if (name == "AVX2_INT8") return dispatch::supportAVX2() && dispatch::supportFMA();
+        if (name == "AVX512") return dispatch::supportAVX512F();
+        if (name.compare(0, 3, "AVX") == 0) return dispatch::supportAVX() && dispatch::supportFMA();
+        if (name.compare(0, 4, "NEON") == 0) return dispatch::supportNEON();
+        return true;
+    }
+
+    // every CPU arch compiled in, as listed by Processor::info, which the running CPU supports, skipping Auto.
+    inline std::vector<Arch> archs()
+    {
+        std::vector<Arch> list{};
+        std::istringstream info{ ac::core::Processor::info<ac::core::Processor::CPU>() };
+        std::string line{};
+        while (std::getline(info, line))
+        {
+            int idx = 0;
+            char name[64]{};
+            if (std::sscanf(line.c_str(), " [%d] %63s", &idx, name) != 2 || idx == 0) continue;
+            if (supported(name)) list.push_back({ idx, name });
+            else std::printf("[SKIP] %s is not supported by this CPU\n", name);
+        }
+        return list;
+    }
+
+    // the index of the arch called `name`, or 0 for Auto if it is not compiled in.
+    inline int archIndex(const char* name)
+    {
+        for (auto&& arch : archs())
+            if (arch.name == name) return arch.idx;
+        return 0;
+    }
+}
+
+#endif
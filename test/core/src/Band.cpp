@@ -0,0 +1,83 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "AC/Core.hpp"
+
+#include "Archs.hpp"
+
+// the result of processing band by band within `budget` bytes must match processing the whole image,
+// exactly for a power of 2 and within the rounding of the final resize for other factors, and every source row must be read once in order
+static bool check(ac::core::Processor& processor, const int w, const int h, const int c, const double factor, const std::size_t budget, const int tolerance)
+{
+    ac::core::Image src{ w, h, c, ac::core::Image::UInt8 };
+    for (int i = 0; i < h; i++)
+        for (int j = 0; j < w * c; j++) src.line(i)[j] = static_cast<std::uint8_t>(i * 7 + j * 13 + (i * j) / 5);
+    auto ref = processor.process(src, factor);
+
+    ac::core::Image dst{ ref.width(), ref.height(), c, ac::core::Image::UInt8 };
+    int next = 0, bands = 0, rows = 0;
+    bool ordered = true;
+    bool done = processor.processBands(w, h, c, ac::core::Image::UInt8,
+        [&](const int y, ac::core::Image& band) {
+            ordered = ordered && y == next;
+            next = y + band.height();
+            for (int i = 0; i < band.height(); i++) std::memcpy(band.line(i), src.line(y + i), static_cast<std::size_t>(w) * c);
+            return true;
+        },
+        [&](const int y, const ac::core::Image& band) {
+            ordered = ordered && y == rows && band.width() == dst.width();
+            rows = y + band.height();
+            bands++;
+            for (int i = 0; i < band.height(); i++) std::memcpy(dst.line(y + i), band.line(i), static_cast<std::size_t>(band.width()) * c);
+            return true;
+        }, factor, budget);
+
+    int error = 0;
+    for (int i = 0; i < ref.height(); i++)
+        for (int j = 0; j < ref.width() * c; j++)
+        {
+            int diff = std::abs(static_cast<int>(ref.line(i)[j]) - static_cast<int>(dst.line(i)[j]));
+            if (diff > error) error = diff;
+        }
+
+    bool ok = done && ordered && next == h && rows == ref.height() && error <= tolerance;
+    std::printf("[%s] %s %dx%dx%d x%.2lf in %zu bytes: %d bands, max error %d\n", ok ? "PASS" : "FAIL", processor.name(), w, h, c, factor, budget, bands, error);
+    return ok;
+}
+
+// a budget too small for a single band is refused before anything is read
+static bool checkBudget(ac::core::Processor& processor)
+{
+    bool called = false;
+    bool done = processor.processBands(640, 480, 3, ac::core::Image::UInt8,
+        [&](const int, ac::core::Image&) { return called = true; },
+        [&](const int, const ac::core::Image&) { return called = true; }, 2.0, 4096);
+    bool ok = !done && !called;
+    std::printf("[%s] %s budget\n", ok ? "PASS" : "FAIL", processor.name());
+    return ok;
+}
+
+int main()
+{
+    bool ok = true;
+    const int channels[] = { 1, 3, 4 };
+    for (auto&& arch : ac::test::archs())
+    {
+        auto processor = ac::core::Processor::create<ac::core::Processor::CPU>(arch.idx, ac::core::model::ACNet{ ac::core::model::ACNet::Variant::HDN0 });
+        // AVX_WINOGRAD rounds the outputs of a 2x2 block of pixels together, the blocks fall elsewhere in a band than in the whole image,
+        // so its result may differ by 1 for each pass of the model
+        const int pass = arch.name == "AVX_WINOGRAD" ? 1 : 0;
+        ok = checkBudget(*processor) && ok;
+        for (auto c : channels)
+        {
+            ok = check(*processor, 160, 301, c, 2.0, 1 << 20, pass) && ok;
+            ok = check(*processor, 97, 203, c, 4.0, 2 << 20, 2 * pass) && ok;
+            ok = check(*processor, 160, 300, c, 1.5, 1 << 20, 2 + pass) && ok;
+            ok = check(*processor, 160, 120, c, 2.0, 1 << 30, 0) && ok;
+        }
+    }
+    return ok ? 0 : 1;
+}
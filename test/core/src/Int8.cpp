@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "AC/Core.hpp"
+
+#include "Archs.hpp"
+
+// the lowest PSNR against Generic, in dB, and the largest difference to it, as a fraction of the full range,
+// the INT8 arch may have with the calibrated ranges of the model. ranges that clip the outputs of a layer break both.
+static constexpr double MinPSNR = 42.0;
+static constexpr double MaxError = 0.1;
+
+// a frame in the style of cel animation: a gradient, flat shapes with dark outlines, hatching and fine high-contrast strokes
+static ac::core::Image frame(const int w, const int h, const ac::core::Image::ElementType type)
+{
+    ac::core::Image image{ w, h, 1, type };
+    const float max = type == ac::core::Image::UInt8 ? 255.0f : 65535.0f;
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+        {
+            float v = 0.8f - 0.5f * static_cast<float>(y) / static_cast<float>(h);
+            for (int k = 0; k < 5; k++)
+            {
+                const float cx = w * (0.15f + 0.18f * k), cy = h * (0.3f + 0.1f * (k % 3)), a = w * 0.12f, b = h * (0.2f + 0.05f * k);
+                const float dx = (x - cx) / a, dy = (y - cy) / b;
+                const float d = (std::sqrt(dx * dx + dy * dy) - 1.0f) * std::min(a, b);
+                const float fill = (k % 2 && (x + y) % 4 == 0) ? 0.1f : 0.2f + 0.15f * k;
+                v += (fill - v) * std::clamp(0.5f - d, 0.0f, 1.0f);
+                v += (0.05f - v) * std::clamp(0.5f - (std::abs(d) - 1.0f - 0.5f * k), 0.0f, 1.0f);
+            }
+            if (y > h * 3 / 4 && y < h * 3 / 4 + 7 && ((x * 7 + y * 3) % 5 == 0 || x % 6 == 0)) v = 1.0f;
+            const auto value = std::lround(std::clamp(v, 0.0f, 1.0f) * max);
+            if (type == ac::core::Image::UInt8) *image.pixel(x, y) = static_cast<std::uint8_t>(value);
+            else
+            {
+                const auto sample = static_cast<std::uint16_t>(value);
+                std::memcpy(image.pixel(x, y), &sample, sizeof(sample));
+            }
+        }
+    return image;
+}
+
+static double sample(const ac::core::Image& image, const int x, const int y)
+{
+    if (image.type() == ac::core::Image::UInt8) return *image.pixel(x, y) / 255.0;
+    std::uint16_t v = 0;
+    std::memcpy(&v, image.pixel(x, y), sizeof(v));
+    return v / 65535.0;
+}
+
+// the result of the INT8 arch must stay within MinPSNR and MaxError of Generic, for 8-bit and 16-bit frames
+static bool check(ac::core::Processor& processor, ac::core::Processor& generic, const int w, const int h, const ac::core::Image::ElementType type)
+{
+    auto src = frame(w, h, type);
+    auto dst = processor.process(src, 2.0);
+    auto ref = generic.process(src, 2.0);
+
+    double sse = 0.0, error = 0.0;
+    for (int i = 0; i < ref.height(); i++)
+        for (int j = 0; j < ref.width(); j++)
+        {
+            const double diff = std::abs(sample(dst, j, i) - sample(ref, j, i));
+            sse += diff * diff;
+            error = std::max(error, diff);
+        }
+    const double mse = sse / (static_cast<double>(ref.width()) * ref.height());
+    const double psnr = mse > 0.0 ? 10.0 * std::log10(1.0 / mse) : INFINITY;
+
+    bool ok = psnr >= MinPSNR && error <= MaxError;
+    std::printf("[%s] %s %dx%d %s: PSNR %.2lf dB, max error %.4lf\n", ok ? "PASS" : "FAIL", processor.name(), w, h,
+        type == ac::core::Image::UInt8 ? "8-bit" : "16-bit", psnr, error);
+    return ok;
+}
+
+int main()
+{
+    const int int8 = ac::test::archIndex("AVX2_INT8");
+    if (!int8)
+    {
+        std::printf("[SKIP] no INT8 arch\n");
+        return 0;
+    }
+
+    bool ok = true;
+    const ac::core::model::ACNet::Variant variants[] = {
+        ac::core::model::ACNet::Variant::HDN0, ac::core::model::ACNet::Variant::HDN1,
+        ac::core::model::ACNet::Variant::HDN2, ac::core::model::ACNet::Variant::HDN3
+    };
+    for (auto variant : variants)
+    {
+        ac::core::model::ACNet model{ variant };
+        auto processor = ac::core::Processor::create<ac::core::Processor::CPU>(int8, model);
+        auto generic = ac::core::Processor::create<ac::core::Processor::CPU>(ac::test::archIndex("Generic"), model);
+        ok = check(*processor, *generic, 256, 192, ac::core::Image::UInt8) && ok;
+        ok = check(*processor, *generic, 256, 192, ac::core::Image::UInt16) && ok;
+    }
+    return ok ? 0 : 1;
+}
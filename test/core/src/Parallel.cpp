@@ -0,0 +1,101 @@
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+#include "AC/Core/Parallel.hpp"
+#include "AC/Core/Runtime.hpp"
+
+// every index of the range runs exactly once, a chunk of `grain` indices runs in order on one thread, and a nested parallelFor runs serially
+static bool checkGrain(const int first, const int last, const int grain)
+{
+    const int count = last > first ? last - first : 0;
+    auto runs = std::make_unique<std::atomic_int[]>(count + 1);
+    auto threads = std::make_unique<std::thread::id[]>(count + 1);
+    std::atomic_bool nested = true;
+    ac::core::parallelFor(first, last, grain, [&](const int i) {
+        runs[i - first]++;
+        threads[i - first] = std::this_thread::get_id();
+        auto self = std::this_thread::get_id();
+        ac::core::parallelFor(0, 4, [&](const int) { if (std::this_thread::get_id() != self) nested = false; });
+    });
+
+    bool ok = nested;
+    const int step = grain > 1 ? grain : 1;
+    for (int i = 0; i < count; i++) ok = ok && runs[i] == 1 && (i % step == 0 || threads[i] == threads[i - 1]);
+    std::printf("[%s] parallelFor [%d, %d) grain %d\n", ok ? "PASS" : "FAIL", first, last, grain);
+    return ok;
+}
+
+// an exception thrown by the body reaches the caller of parallelFor, whichever thread ran the index, no index runs twice,
+// and nothing is left running afterwards
+static bool checkThrow(const int count, const int grain, const int at)
+{
+    auto runs = std::make_unique<std::atomic_int[]>(count);
+    bool caught = false;
+    try
+    {
+        ac::core::parallelFor(0, count, grain, [&](const int i) {
+            runs[i]++;
+            if (at < 0 || i == at) throw std::runtime_error{ "parallelFor" };
+        });
+    }
+    catch (const std::runtime_error&) { caught = true; }
+
+    bool ok = caught;
+    for (int i = 0; i < count; i++) ok = ok && runs[i] <= 1;
+    // the runtime is still usable
+    std::atomic_int after = 0;
+    ac::core::parallelFor(0, count, grain, [&](const int) { after++; });
+    ok = ok && after == count;
+    std::printf("[%s] parallelFor throws at %d of %d grain %d\n", ok ? "PASS" : "FAIL", at, count, grain);
+    return ok;
+}
+
+// every pixel of the area is covered by exactly one tile, the tiles on the right and bottom edges are clipped to it
+static bool checkTiles(const int width, const int height, const int tileWidth, const int tileHeight)
+{
+    auto covered = std::make_unique<std::atomic_int[]>(static_cast<std::size_t>(width) * height + 1);
+    std::atomic_int tiles = 0;
+    std::atomic_bool bounded = true;
+    ac::core::parallelForTiles(width, height, tileWidth, tileHeight, [&](const int x, const int y, const int w, const int h) {
+        tiles++;
+        if (x % tileWidth || y % tileHeight || w <= 0 || h <= 0 || w > tileWidth || h > tileHeight || x + w > width || y + h > height ||
+            (w < tileWidth && x + w != width) || (h < tileHeight && y + h != height)) bounded = false;
+        for (int i = y; i < y + h && bounded; i++)
+            for (int j = x; j < x + w; j++) covered[static_cast<std::size_t>(i) * width + j]++;
+    });
+
+    const int expected = ((width + tileWidth - 1) / tileWidth) * ((height + tileHeight - 1) / tileHeight);
+    bool ok = bounded && tiles == expected;
+    for (std::size_t i = 0; i < static_cast<std::size_t>(width) * height && ok; i++) ok = covered[i] == 1;
+    std::printf("[%s] parallelForTiles %dx%d in %dx%d: %d tiles\n", ok ? "PASS" : "FAIL", width, height, tileWidth, tileHeight, tiles.load());
+    return ok;
+}
+
+int main()
+{
+    // more threads than a small test machine has, so the chunks really interleave
+    ac::core::runtime::setThreads(4);
+
+    bool ok = true;
+    ok = checkGrain(0, 1000, 1) && ok;
+    ok = checkGrain(0, 1000, 7) && ok;
+    ok = checkGrain(-50, 53, 16) && ok;
+    ok = checkGrain(0, 3, 100) && ok;
+    ok = checkGrain(0, 100, 0) && ok;
+    ok = checkGrain(5, 5, 4) && ok;
+
+    ok = checkThrow(1000, 1, 0) && ok;
+    ok = checkThrow(1000, 1, 999) && ok;
+    ok = checkThrow(1000, 7, -1) && ok;
+    ok = checkThrow(3, 100, 1) && ok;
+
+    ok = checkTiles(300, 200, 96, 96) && ok;
+    ok = checkTiles(96, 192, 96, 96) && ok;
+    ok = checkTiles(97, 1, 96, 96) && ok;
+    ok = checkTiles(1, 1, 96, 96) && ok;
+    ok = checkTiles(1000, 7, 13, 3) && ok;
+    return ok ? 0 : 1;
+}
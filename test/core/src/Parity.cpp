@@ -0,0 +1,64 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "AC/Core.hpp"
+
+#include "Archs.hpp"
+
+// the largest difference to Generic, in LSB of the 8-bit result, an FP32 arch may have: the same math in another order
+static constexpr int ToleranceFP32 = 1;
+// an FP16 arch stores the feature maps between layers in half precision, 11 significant bits, the error builds up over the layers
+static constexpr int ToleranceFP16 = 2;
+
+// the result of every arch must match Generic within its tolerance, for both execution policies, across tile boundaries and odd sizes.
+// the INT8 arch is checked against its PSNR in Int8.cpp, it is not meant to be close to the LSB.
+static bool check(ac::core::Processor& processor, ac::core::Processor& generic, const int w, const int h, const int c, const double factor, const int tolerance)
+{
+    ac::core::Image src{ w, h, c, ac::core::Image::UInt8 };
+    for (int i = 0; i < h; i++)
+        for (int j = 0; j < w * c; j++) src.line(i)[j] = static_cast<std::uint8_t>(i * 7 + j * 13 + (i * j) / 5);
+
+    auto ref = generic.process(src, factor);
+    bool ok = true;
+    const int policies[] = { ac::core::Processor::ExecutionSerial, ac::core::Processor::ExecutionParallel };
+    for (auto policy : policies)
+    {
+        processor.setExecutionPolicy(policy);
+        auto dst = processor.process(src, factor);
+        int error = 0;
+        bool same = dst.width() == ref.width() && dst.height() == ref.height();
+        for (int i = 0; i < ref.height() && same; i++)
+            for (int j = 0; j < ref.width() * c; j++)
+            {
+                int diff = std::abs(static_cast<int>(ref.line(i)[j]) - static_cast<int>(dst.line(i)[j]));
+                if (diff > error) error = diff;
+            }
+        same = same && error <= tolerance;
+        std::printf("[%s] %s %s %dx%dx%d x%.2lf: max error %d\n", same ? "PASS" : "FAIL", processor.name(),
+            policy == ac::core::Processor::ExecutionSerial ? "serial" : "parallel", w, h, c, factor, error);
+        ok = ok && same;
+    }
+    return ok;
+}
+
+int main()
+{
+    ac::core::model::ACNet model{ ac::core::model::ACNet::Variant::HDN0 };
+    auto generic = ac::core::Processor::create<ac::core::Processor::CPU>(ac::test::archIndex("Generic"), model);
+    generic->setExecutionPolicy(ac::core::Processor::ExecutionSerial);
+
+    bool ok = true;
+    for (auto&& arch : ac::test::archs())
+    {
+        if (arch.name == "Generic" || arch.name == "AVX2_INT8") continue;
+        const int tolerance = arch.name.find("FP16") != std::string::npos ? ToleranceFP16 : ToleranceFP32;
+        auto processor = ac::core::Processor::create<ac::core::Processor::CPU>(arch.idx, model);
+        ok = check(*processor, *generic, 300, 200, 1, 2.0, tolerance) && ok;
+        ok = check(*processor, *generic, 97, 131, 3, 2.0, tolerance) && ok;
+        // x4 runs the model twice, a difference after the first pass is upscaled again by the second
+        ok = check(*processor, *generic, 67, 45, 4, 4.0, 2 * tolerance) && ok;
+        ok = check(*processor, *generic, 1, 1, 1, 2.0, tolerance) && ok;
+    }
+    return ok ? 0 : 1;
+}
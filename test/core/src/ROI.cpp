@@ -0,0 +1,76 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "AC/Core.hpp"
+
+#include "Archs.hpp"
+
+// a view shares the buffer of its image, is clipped to it and keeps the buffer alive
+static bool checkView()
+{
+    ac::core::Image image{ 160, 120, 3, ac::core::Image::UInt8 };
+    auto count = ac::core::detail::allocations();
+    auto roi = image.roi(10, 20, 30, 40);
+    bool ok = ac::core::detail::allocations() == count &&
+        roi.ptr() == image.ptr(10, 20) && roi.stride() == image.stride() && roi.width() == 30 && roi.height() == 40 && roi.channels() == 3;
+
+    auto clipped = image.roi(-10, 100, 200, 40);
+    ok = ok && clipped.ptr() == image.ptr(0, 100) && clipped.width() == 160 && clipped.height() == 20;
+    ok = ok && image.roi(160, 0, 10, 10).empty() && image.roi(0, 0, 0, 10).empty() && ac::core::Image{}.roi(0, 0, 10, 10).empty();
+
+    std::memset(roi.ptr(), 0x5a, roi.channelSize());
+    image = ac::core::Image{};
+    ok = ok && *roi.data() == 0x5a;
+
+    std::printf("[%s] view\n", ok ? "PASS" : "FAIL");
+    return ok;
+}
+
+// processing a view of a larger source into a view of a larger destination gives the same pixels as processing standalone images,
+// and leaves the rest of the destination untouched
+static bool check(ac::core::Processor& processor, const int w, const int h, const int c, const double factor)
+{
+    constexpr int margin = 7;
+
+    ac::core::Image canvas{ w + 2 * margin, h + 2 * margin, c, ac::core::Image::UInt8 };
+    for (int i = 0; i < canvas.height(); i++)
+        for (int j = 0; j < canvas.width() * c; j++) canvas.line(i)[j] = static_cast<std::uint8_t>(i * 7 + j * 13);
+    auto src = canvas.roi(margin, margin, w, h);
+    ac::core::Image packed{ w, h, c, ac::core::Image::UInt8 };
+    for (int i = 0; i < h; i++) std::memcpy(packed.line(i), src.line(i), static_cast<std::size_t>(w) * src.channelSize());
+
+    auto ref = processor.process(packed, factor);
+    ac::core::Image out{ ref.width() + 2 * margin, ref.height() + 2 * margin, c, ac::core::Image::UInt8 };
+    std::memset(out.ptr(), 0xa5, out.size());
+    auto dst = out.roi(margin, margin, ref.width(), ref.height());
+    processor.process(src, dst, factor);
+
+    bool ok = dst.ptr() == out.ptr(margin, margin);
+    for (int i = 0; i < out.height() && ok; i++)
+        for (int j = 0; j < out.width() * c && ok; j++)
+        {
+            const bool inside = i >= margin && i < margin + ref.height() && j >= margin * c && j < (margin + ref.width()) * c;
+            ok = out.line(i)[j] == (inside ? ref.line(i - margin)[j - margin * c] : 0xa5);
+        }
+
+    std::printf("[%s] %s %dx%dx%d x%.2lf\n", ok ? "PASS" : "FAIL", processor.name(), w, h, c, factor);
+    return ok;
+}
+
+int main()
+{
+    bool ok = checkView();
+    const int channels[] = { 1, 3, 4 };
+    for (auto&& arch : ac::test::archs())
+    {
+        auto processor = ac::core::Processor::create<ac::core::Processor::CPU>(arch.idx, ac::core::model::ACNet{ ac::core::model::ACNet::Variant::HDN0 });
+        for (auto c : channels)
+        {
+            ok = check(*processor, 160, 120, c, 2.0) && ok;
+            ok = check(*processor, 160, 120, c, 1.5) && ok;
+            ok = check(*processor, 640, 480, c, 2.0) && ok;
+        }
+    }
+    return ok ? 0 : 1;
+}
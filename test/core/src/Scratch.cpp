@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+#include "AC/Core.hpp"
+
+// bytes of image buffers currently allocated
+static std::atomic_size_t live = 0;
+
+static ac::core::Allocator counting() noexcept
+{
+    return {
+        [](const std::size_t size, void*) -> void* { live += size; return std::malloc(size); },
+        [](void* const ptr, const std::size_t size, void*) { live -= size; std::free(ptr); },
+        nullptr
+    };
+}
+
+static ac::core::Image source(const int w, const int h, const int c)
+{
+    ac::core::Image src{ w, h, c, ac::core::Image::UInt8 };
+    for (int i = 0; i < h; i++)
+        for (int j = 0; j < w * c; j++) src.line(i)[j] = static_cast<std::uint8_t>(i * 7 + j * 13);
+    return src;
+}
+
+// frames processed on a new thread each time keep no memory once their threads have exited
+static bool checkThreads(const int c)
+{
+    auto processor = ac::core::Processor::create<ac::core::Processor::CPU>(0, ac::core::model::ACNet{ ac::core::model::ACNet::Variant::HDN0 });
+    processor->setExecutionPolicy(ac::core::Processor::ExecutionSerial);
+    auto src = source(160, 120, c);
+
+    const std::size_t base = live;
+    std::size_t peak = 0, used = 0;
+    for (int i = 0; i < 32; i++)
+    {
+        std::thread{ [&]() {
+            auto dst = processor->process(src, 2.0);
+            used = live - base;
+        } }.join();
+        peak = std::max(peak, live - base);
+    }
+
+    bool ok = used > 0 && peak == 0;
+    std::printf("[%s] %s 32 threads x%d channels: %zu bytes in use by a frame, %zu bytes left after its thread\n", ok ? "PASS" : "FAIL", processor->name(), c, used, peak);
+    return ok;
+}
+
+// a processor destroyed while a thread that used it is still running frees the arena of that thread, and the thread exits cleanly after
+static bool checkProcessorFirst()
+{
+    auto processor = ac::core::Processor::create<ac::core::Processor::CPU>(0, ac::core::model::ACNet{ ac::core::model::ACNet::Variant::HDN0 });
+    processor->setExecutionPolicy(ac::core::Processor::ExecutionSerial);
+    auto src = source(160, 120, 3);
+
+    std::mutex mtx{};
+    std::condition_variable cnd{};
+    int stage = 0;
+    const std::size_t base = live;
+    std::thread thread{ [&]() {
+        processor->process(src, 2.0);
+        std::unique_lock lock{ mtx };
+        stage = 1;
+        cnd.notify_all();
+        cnd.wait(lock, [&]() { return stage == 2; });
+    } };
+    std::size_t used = 0;
+    {
+        std::unique_lock lock{ mtx };
+        cnd.wait(lock, [&]() { return stage == 1; });
+        used = live - base;
+        processor.reset();
+        stage = 2;
+        cnd.notify_all();
+    }
+    const std::size_t left = live - base;
+    thread.join();
+
+    bool ok = used > 0 && left == 0 && live == base;
+    std::printf("[%s] processor destroyed before the thread: %zu bytes in use, %zu bytes left\n", ok ? "PASS" : "FAIL", used, left);
+    return ok;
+}
+
+int main()
+{
+    ac::core::allocator::set(counting());
+
+    bool ok = true;
+    ok = checkThreads(1) && ok;
+    ok = checkThreads(3) && ok;
+    ok = checkProcessorFirst() && ok;
+    return ok ? 0 : 1;
+}
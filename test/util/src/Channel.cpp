@@ -1,4 +1,6 @@
+#include <atomic>
 #include <chrono>
+#include <cstdio>
 #include <iostream>
 #include <mutex>
 #include <thread>
@@ -7,6 +9,78 @@
 #include "AC/Util/Channel.hpp"
 #include "AC/Util/ThreadPool.hpp"
 
+// true if `flag` becomes set within a second
+static bool waitFor(const std::atomic_bool& flag)
+{
+    for (int i = 0; i < 1000 && !flag; i++) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return flag;
+}
+// a blocked producer has had the time to push if it could
+static void settle()
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+}
+
+// a capacity below the current fill keeps the objects already in the channel, in order,
+// and blocks producers until consumers bring the fill below the new capacity
+static bool checkShrink()
+{
+    ac::util::Channel<int> chan{ 4 };
+    for (int i = 0; i < 4; i++) chan << i;
+    chan.setCapacity(2);
+    bool ok = chan.capacity() == 2 && chan.size() == 4;
+
+    std::atomic_bool pushed = false;
+    std::thread producer{ [&]() { chan << 4; pushed = true; } };
+    int n = -1;
+    chan >> n;
+    ok = ok && n == 0;
+    settle();
+    ok = ok && !pushed && chan.size() == 3;
+    chan >> n;
+    ok = ok && n == 1;
+    settle();
+    ok = ok && !pushed && chan.size() == 2;
+    chan >> n;
+    ok = ok && n == 2 && waitFor(pushed);
+
+    if (!pushed) chan.setCapacity(8);
+    producer.join();
+    for (int i = 3; i < 5; i++)
+    {
+        chan >> n;
+        ok = ok && n == i;
+    }
+    ok = ok && chan.empty();
+    std::printf("[%s] shrink the capacity below the fill\n", ok ? "PASS" : "FAIL");
+    return ok;
+}
+
+// a larger capacity wakes a producer blocked on a full channel, without any consumer
+static bool checkGrow()
+{
+    ac::util::Channel<int> chan{ 1 };
+    chan << 0;
+
+    std::atomic_bool pushed = false;
+    std::thread producer{ [&]() { chan << 1; chan << 2; pushed = true; } };
+    settle();
+    bool ok = !pushed && chan.size() == 1;
+    chan.setCapacity(3);
+    ok = ok && waitFor(pushed) && chan.size() == 3 && chan.capacity() == 3;
+
+    if (!pushed) chan.setCapacity(8);
+    producer.join();
+    for (int i = 0; i < 3; i++)
+    {
+        int n = -1;
+        chan >> n;
+        ok = ok && n == i;
+    }
+    std::printf("[%s] grow the capacity while a producer is blocked\n", ok ? "PASS" : "FAIL");
+    return ok;
+}
+
 int main()
 {
     std::mutex mtx{};
@@ -30,5 +104,8 @@ int main()
         std::this_thread::sleep_for(std::chrono::seconds(1));
     }
 
-    return 0;
+    bool ok = true;
+    ok = checkShrink() && ok;
+    ok = checkGrow() && ok;
+    return ok ? 0 : 1;
 }
@@ -0,0 +1,127 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "AC/Util/ThreadPool.hpp"
+
+// counts the live copies of a callable, to check that a Task destroys exactly what it constructs
+static std::atomic_int live = 0;
+
+template<std::size_t Size>
+struct Counted
+{
+    std::array<void*, Size> payload{};
+    std::atomic_int* calls;
+
+    explicit Counted(std::atomic_int* const calls) noexcept : calls(calls) { live++; }
+    Counted(const Counted& other) noexcept : payload(other.payload), calls(other.calls) { live++; }
+    Counted(Counted&& other) noexcept : payload(other.payload), calls(other.calls) { live++; }
+    ~Counted() noexcept { live--; }
+    void operator()() const { (*calls)++; }
+};
+
+// callables that fit the inline buffer and ones larger than it are called once per call, survive moves and are destroyed once
+template<std::size_t Size>
+static bool checkTask(const char* const kind)
+{
+    std::atomic_int calls = 0;
+    {
+        ac::util::Task task{ Counted<Size>{ &calls } };
+        ac::util::Task moved{ std::move(task) };
+        ac::util::Task assigned{};
+        assigned = std::move(moved);
+        assigned();
+        assigned();
+        if (task || moved || !assigned) calls = -1;
+    }
+    bool ok = calls == 2 && live == 0;
+    std::printf("[%s] task %s, %zu bytes\n", ok ? "PASS" : "FAIL", kind, sizeof(Counted<Size>));
+    return ok;
+}
+
+// a Task and the pool take callables that can only be moved, with arguments that can only be moved
+static bool checkMoveOnly()
+{
+    ac::util::ThreadPool pool{ 2 };
+    auto value = std::make_unique<int>(42);
+    std::promise<int> promise{};
+    auto result = promise.get_future();
+    pool.exec([value = std::move(value), promise = std::move(promise)]() mutable { promise.set_value(*value); });
+    auto sum = pool.exec([](std::unique_ptr<int> a, std::unique_ptr<int> b) { return *a + *b; }, std::make_unique<int>(1), std::make_unique<int>(2));
+    bool ok = result.get() == 42 && sum.get() == 3;
+    std::printf("[%s] move-only callables\n", ok ? "PASS" : "FAIL");
+    return ok;
+}
+
+// many tiny tasks submitted from outside and from inside the pool all run exactly once
+static bool checkMany(const std::size_t threads, const int count)
+{
+    std::atomic_int runs = 0, nested = 0;
+    {
+        ac::util::ThreadPool pool{ threads };
+        for (int i = 0; i < count; i++) pool.exec([&]() {
+            if (++runs % 64 == 0) pool.exec([&]() { nested++; });
+        });
+        std::vector<std::future<int>> results{};
+        for (int i = 0; i < 100; i++) results.emplace_back(pool.exec([](const int i) { return i * 2; }, i));
+        for (int i = 0; i < 100; i++) if (results[i].get() != i * 2) runs = -1;
+    }
+    bool ok = runs == count && nested == count / 64;
+    std::printf("[%s] %d small tasks on %zu threads\n", ok ? "PASS" : "FAIL", count, threads);
+    return ok;
+}
+
+// execBulk runs exactly `count` copies, whether it is called from outside the pool or from one of its threads
+static bool checkBulk(const std::size_t threads, const std::size_t count)
+{
+    std::atomic_size_t outer = 0, inner = 0;
+    {
+        ac::util::ThreadPool pool{ threads };
+        pool.execBulk(count, [&]() { outer++; });
+        pool.execBulk(0, [&]() { outer += count; });
+        pool.exec([&]() { pool.execBulk(count, [&]() { inner++; }); });
+    }
+    bool ok = outer == count && inner == count;
+    std::printf("[%s] execBulk %zu on %zu threads\n", ok ? "PASS" : "FAIL", count, threads);
+    return ok;
+}
+
+// the destructor runs the work still queued before it joins the threads
+static bool checkDestruction()
+{
+    std::atomic_int runs = 0;
+    std::atomic_bool started = false;
+    {
+        ac::util::ThreadPool pool{ 1 };
+        pool.exec([&]() {
+            started = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        });
+        while (!started) std::this_thread::yield();
+        for (int i = 0; i < 1000; i++) pool.exec([&]() { runs++; });
+        pool.execBulk(1000, [&]() { runs++; });
+    }
+    bool ok = runs == 2000;
+    std::printf("[%s] destruction with queued work: %d of 2000 ran\n", ok ? "PASS" : "FAIL", runs.load());
+    return ok;
+}
+
+int main()
+{
+    bool ok = true;
+    ok = checkTask<1>("inline") && ok;
+    ok = checkTask<ac::util::Task::BufferSize / sizeof(void*) + 1>("on heap") && ok;
+    ok = checkMoveOnly() && ok;
+    ok = checkMany(1, 10000) && ok;
+    ok = checkMany(4, 100000) && ok;
+    ok = checkBulk(1, 1000) && ok;
+    ok = checkBulk(3, 1) && ok;
+    ok = checkBulk(4, 10007) && ok;
+    ok = checkDestruction() && ok;
+    return ok ? 0 : 1;
+}
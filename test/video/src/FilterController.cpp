@@ -0,0 +1,69 @@
+#include <cstddef>
+#include <cstdio>
+
+#include "AC/Video/Filter.hpp"
+
+// feed the controller one window of samples with the channels `decode` and `encode` quarters full,
+// it must not decide before the window is complete and must end with `expected` active workers
+static bool step(ac::video::detail::FilterController& controller, const std::size_t decode, const std::size_t encode, const std::size_t expected)
+{
+    const std::size_t prev = controller.active();
+    const std::size_t capacity = controller.capacity();
+    const std::size_t window = capacity < 8 ? 8 : capacity * 2;
+
+    bool ok = capacity == prev * 2;
+    for (std::size_t i = 1; i < window; i++) ok = !controller.update(capacity * decode / 4, capacity * encode / 4) && ok;
+    const bool changed = controller.update(capacity * decode / 4, capacity * encode / 4);
+    ok = ok && changed == (expected != prev) && controller.active() == expected && controller.capacity() == expected * 2;
+    return ok;
+}
+
+// encode-bound: the encode channel is full, one fewer worker each window, never below 1, whatever the decode channel is
+static bool checkEncodeBound()
+{
+    ac::video::detail::FilterController controller{ 4 };
+    bool ok = controller.active() == 4;
+    ok = step(controller, 4, 4, 3) && ok;
+    ok = step(controller, 2, 4, 2) && ok;
+    ok = step(controller, 0, 4, 1) && ok;
+    ok = step(controller, 4, 4, 1) && ok;
+    std::printf("[%s] encode-bound\n", ok ? "PASS" : "FAIL");
+    return ok;
+}
+
+// compute-bound: the decode channel is full and the encode channel is not, one more worker each window, capped at `maxWorkers`
+static bool checkComputeBound()
+{
+    ac::video::detail::FilterController controller{ 3 };
+    bool ok = true;
+    ok = step(controller, 0, 0, 2) && ok;
+    ok = step(controller, 0, 0, 1) && ok;
+    ok = step(controller, 4, 0, 2) && ok;
+    ok = step(controller, 3, 2, 3) && ok;
+    ok = step(controller, 4, 2, 3) && ok;
+    std::printf("[%s] compute-bound\n", ok ? "PASS" : "FAIL");
+    return ok;
+}
+
+// decode-bound: the decode channel is almost empty, one fewer worker each window, never below 1,
+// and a channel that is neither full nor empty leaves the workers as they are
+static bool checkDecodeBound()
+{
+    ac::video::detail::FilterController controller{ 8 };
+    bool ok = true;
+    ok = step(controller, 2, 2, 8) && ok;
+    for (std::size_t expected = 7; expected > 0; expected--) ok = step(controller, 1, 0, expected) && ok;
+    ok = step(controller, 0, 0, 1) && ok;
+    ok = step(controller, 2, 2, 1) && ok;
+    std::printf("[%s] decode-bound\n", ok ? "PASS" : "FAIL");
+    return ok;
+}
+
+int main()
+{
+    bool ok = true;
+    ok = checkEncodeBound() && ok;
+    ok = checkComputeBound() && ok;
+    ok = checkDecodeBound() && ok;
+    return ok ? 0 : 1;
+}
@@ -1,3 +1,4 @@
+#include <cmath>
 #include <cstdio>
 #include <cstdint>
 #include <cstdlib>
@@ -29,6 +30,29 @@ static void benchmarkParallel(const std::shared_ptr<ac::core::Processor>& proces
     std::printf("%s: parallel average FPS %lf\n", processor->name(), batch / stopwatch.elapsed());
 }
 
+// compare with the Generic CPU arch, the reference implementation of the model
+static void accuracy(const std::shared_ptr<ac::core::Processor>& processor, const ac::core::Image& image)
+{
+    ac::core::model::ACNet model{ ac::core::model::ACNet::Variant::HDN0 };
+    std::shared_ptr<ac::core::Processor> reference{};
+    for (int i = 1; !reference || std::strcmp(reference->name(), "Generic"); i++) reference = ac::core::Processor::create<ac::core::Processor::CPU>(i, model);
+
+    auto dst = processor->process(image, 2.0);
+    auto ref = reference->process(image, 2.0);
+
+    int maxError = 0;
+    double sse = 0.0;
+    for (int i = 0; i < dst.height(); i++)
+        for (int j = 0; j < dst.width(); j++)
+        {
+            int error = std::abs(static_cast<int>(*dst.pixel(j, i)) - static_cast<int>(*ref.pixel(j, i)));
+            if (error > maxError) maxError = error;
+            sse += static_cast<double>(error) * error;
+        }
+    double mse = sse / (static_cast<double>(dst.width()) * dst.height());
+    std::printf("%s: max error %d, PSNR %lf dB against %s\n", processor->name(), maxError, mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : INFINITY, reference->name());
+}
+
 int main(int argc, char* argv[])
 {
     std::printf("usage: [processor] [device] [width] [height] [batch] [threads]\n");
@@ -66,6 +90,7 @@ int main(int argc, char* argv[])
         for (int j = 0; j < image.width(); j++)
             *image.pixel(j, i) = static_cast<std::uint8_t>(d(gen));
 
+    accuracy(processor, image);
     benchmark(processor, image, batch);
     benchmarkParallel(processor, image, batch, threads > 0 ? threads : (ac::util::ThreadPool::hardwareThreads() + 1));
 
@@ -0,0 +1,357 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AC/Core.hpp"
+#include "AC/Core/Util.hpp"
+
+using ACNet = ac::core::model::ACNet;
+
+// the range of a layer is this percentile of its outputs over the calibration frames, times the headroom
+#ifndef AC_CALIBRATE_PERCENTILE
+#   define AC_CALIBRATE_PERCENTILE 99.99
+#endif
+#ifndef AC_CALIBRATE_HEADROOM
+#   define AC_CALIBRATE_HEADROOM 1.25
+#endif
+
+static constexpr double CalibratePercentile = AC_CALIBRATE_PERCENTILE;
+static constexpr float CalibrateHeadroom = AC_CALIBRATE_HEADROOM;
+static constexpr int SyntheticWidth = 320, SyntheticHeight = 240;
+
+// float feature map, row-major with interleaved channels
+struct FeatureMap
+{
+    int w, h, c;
+    std::vector<float> data;
+
+    FeatureMap(const int w, const int h, const int c) : w(w), h(h), c(c), data(static_cast<std::size_t>(w) * h * c) {}
+
+    float* at(const int x, const int y) noexcept { return data.data() + (static_cast<std::size_t>(y) * w + x) * c; }
+    // replicate the edges, the padding of the model
+    const float* clamped(const int x, const int y) const noexcept { return data.data() + (static_cast<std::size_t>(std::clamp(y, 0, h - 1)) * w + std::clamp(x, 0, w - 1)) * c; }
+};
+
+// a deterministic frame in the style of cel animation: a gradient background, flat shaded shapes with anti-aliased line art of varying weight,
+// hatching, fine text-like detail and, in every other frame, a little grain. `index` selects the frame, values are in [0, 1].
+static FeatureMap synthetic(const int index, const int w, const int h)
+{
+    std::uint32_t state = 2654435761u * static_cast<std::uint32_t>(index + 1);
+    auto random = [&]() { state = state * 1664525u + 1013904223u; return static_cast<float>(state >> 8) / 16777216.0f; };
+    auto coverage = [](const float d) { return std::clamp(0.5f - d, 0.0f, 1.0f); };
+
+    FeatureMap frame{ w, h, 1 };
+    const float top = 0.3f + 0.7f * random(), bottom = 0.7f * random();
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++) *frame.at(x, y) = top + (bottom - top) * static_cast<float>(y) / static_cast<float>(h);
+
+    for (int shape = 0, shapes = 6 + static_cast<int>(random() * 10); shape < shapes; shape++)
+    {
+        const float cx = random() * w, cy = random() * h, a = 8.0f + random() * w / 4, b = 8.0f + random() * h / 4;
+        const float fill = random(), shade = fill * (0.55f + 0.3f * random()), line = 0.15f * random(), weight = 0.6f + 2.4f * random();
+        const float lightX = random() - 0.5f, lightY = random() - 0.5f;
+        const bool hatched = random() < 0.25f;
+        for (int y = 0; y < h; y++)
+            for (int x = 0; x < w; x++)
+            {
+                const float dx = (static_cast<float>(x) - cx) / a, dy = (static_cast<float>(y) - cy) / b;
+                // approximate distance to the ellipse in pixels
+                const float d = (std::sqrt(dx * dx + dy * dy) - 1.0f) * std::min(a, b);
+                if (d > weight + 1.0f) continue;
+                float& p = *frame.at(x, y);
+                // the two tones of cel shading, split by a hard terminator
+                float color = dx * lightX + dy * lightY > 0.2f ? shade : fill;
+                if (hatched && (x + y) % 4 == 0) color = line;
+                p += (color - p) * coverage(d);
+                p += (line - p) * coverage(std::abs(d) - weight);
+            }
+    }
+
+    // rows of small glyph-like strokes, the finest detail the model sees
+    for (int row = 0, rows = static_cast<int>(random() * 4); row < rows; row++)
+    {
+        const int y0 = static_cast<int>(random() * (h - 8)), x0 = static_cast<int>(random() * w / 2);
+        const float ink = random() < 0.5f ? 0.0f : 1.0f;
+        for (int x = x0; x < std::min(x0 + w / 2, w); x++)
+            for (int y = y0; y < y0 + 7; y++)
+                if ((x * 7 + y * 3 + index) % 5 == 0 || (x % 6 == 0 && y < y0 + 6)) *frame.at(x, y) = ink;
+    }
+
+    for (auto&& value : frame.data)
+    {
+        if (index & 1) value += (random() - 0.5f) * 0.04f;
+        // as an 8-bit frame would be
+        value = std::nearbyint(std::clamp(value, 0.0f, 1.0f) * 255.0f) / 255.0f;
+    }
+    return frame;
+}
+
+// conv3x3 layer `l` with relu in float, the reference
+static FeatureMap conv3x3(const ACNet& model, const int l, const FeatureMap& in)
+{
+    const float* kernels = model.kernels() + ACNet::kernelOffset[l];
+    const float* biases = model.biases() + ACNet::baisOffset[l];
+    FeatureMap out{ in.w, in.h, 8 };
+    ac::core::parallelFor(0, in.h, [&](const int y) {
+        for (int x = 0; x < in.w; x++)
+            for (int n = 0; n < 8; n++)
+            {
+                float sum = biases[n];
+                for (int k = 0; k < 9; k++)
+                {
+                    const float* p = in.clamped(x + k % 3 - 1, y + k / 3 - 1);
+                    for (int c = 0; c < in.c; c++) sum += p[c] * kernels[(n * 9 + k) * in.c + c];
+                }
+                out.at(x, y)[n] = std::max(sum, 0.0f);
+            }
+    });
+    return out;
+}
+// conv3x3 layer `l` as the int8 archs of the CPU processor compute it, the feature maps hold the stored values, value / scale.
+// layer 0 is float, the others use int8 weights quantized per output channel and accumulate in int32.
+static FeatureMap conv3x3Int8(const ACNet& model, const int l, const FeatureMap& in, const float scaleIn, const float scaleOut)
+{
+    const float* kernels = model.kernels() + ACNet::kernelOffset[l];
+    const float* biases = model.biases() + ACNet::baisOffset[l];
+    const int cin = in.c;
+
+    std::vector<int> weights(static_cast<std::size_t>(8) * 9 * cin);
+    float multipliers[8]{};
+    for (int n = 0; n < 8 && l > 0; n++)
+    {
+        float scale = 0.0f;
+        for (int i = 0; i < 9 * cin; i++) scale = std::max(scale, std::abs(kernels[n * 9 * cin + i]));
+        scale = scale > 0.0f ? scale / 127.0f : 1.0f;
+        for (int i = 0; i < 9 * cin; i++) weights[n * 9 * cin + i] = static_cast<int>(std::lrint(kernels[n * 9 * cin + i] / scale));
+        multipliers[n] = scaleIn * scale / scaleOut;
+    }
+
+    FeatureMap out{ in.w, in.h, 8 };
+    ac::core::parallelFor(0, in.h, [&](const int y) {
+        for (int x = 0; x < in.w; x++)
+            for (int n = 0; n < 8; n++)
+            {
+                float value = biases[n] / scaleOut;
+                if (l == 0)
+                    for (int k = 0; k < 9; k++) value += *in.clamped(x + k % 3 - 1, y + k / 3 - 1) * (kernels[n * 9 + k] / scaleOut);
+                else
+                {
+                    int sum = 0;
+                    for (int k = 0; k < 9; k++)
+                    {
+                        const float* p = in.clamped(x + k % 3 - 1, y + k / 3 - 1);
+                        for (int c = 0; c < cin; c++) sum += static_cast<int>(p[c]) * weights[(n * 9 + k) * cin + c];
+                    }
+                    value += static_cast<float>(sum) * multipliers[n];
+                }
+                out.at(x, y)[n] = std::clamp(std::nearbyint(value), 0.0f, 255.0f);
+            }
+    });
+    return out;
+}
+// the deconv2x2 layer, the input is multiplied by `scaleIn`, the result is 8-bit
+static std::vector<std::uint8_t> deconv2x2(const ACNet& model, const FeatureMap& in, const float scaleIn)
+{
+    const float* kernels = model.kernels() + ACNet::kernelOffset[9];
+    std::vector<std::uint8_t> out(static_cast<std::size_t>(in.w) * in.h * 4);
+    for (int y = 0; y < in.h * 2; y++)
+        for (int x = 0; x < in.w * 2; x++)
+        {
+            const int index = ((y & 1) << 1) + (x & 1);
+            const float* p = in.clamped(x / 2, y / 2);
+            float sum = 0.0f;
+            for (int c = 0; c < in.c; c++) sum += p[c] * (kernels[c * 4 + index] * scaleIn);
+            out[static_cast<std::size_t>(y) * in.w * 2 + x] = ac::core::fromFloat<std::uint8_t>(sum);
+        }
+    return out;
+}
+
+static double psnr(const std::vector<std::uint8_t>& a, const std::vector<std::uint8_t>& b, int& maxError)
+{
+    double sse = 0.0;
+    maxError = 0;
+    for (std::size_t i = 0; i < a.size(); i++)
+    {
+        int error = std::abs(static_cast<int>(a[i]) - static_cast<int>(b[i]));
+        maxError = std::max(maxError, error);
+        sse += static_cast<double>(error) * error;
+    }
+    double mse = sse / static_cast<double>(a.size());
+    return mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : INFINITY;
+}
+
+// run the float model on the frames, the range of each conv3x3 layer is the given percentile of its outputs over all the frames, times a headroom.
+// the few largest outputs saturate instead of costing every other value its precision, the headroom keeps frames brighter or sharper than the set from clipping.
+// the percentile is taken from a histogram of the outputs, the first run finds the maximum of each layer for its bins.
+static void calibrate(const ACNet& model, const std::vector<FeatureMap>& frames, const double percentile, const float headroom, float (&ranges)[ACNet::rangeLength()])
+{
+    constexpr int bins = 1 << 16;
+
+    float maximum[ACNet::rangeLength()]{};
+    std::vector<std::size_t> histogram[ACNet::rangeLength()]{};
+    for (int run = 0; run < 2; run++)
+        for (auto&& frame : frames)
+        {
+            FeatureMap map = frame;
+            for (int l = 0; l < ACNet::rangeLength(); l++)
+            {
+                map = conv3x3(model, l, map);
+                if (run == 0) maximum[l] = std::max(maximum[l], *std::max_element(map.data.begin(), map.data.end()));
+                else if (maximum[l] > 0.0f)
+                {
+                    histogram[l].resize(bins);
+                    for (auto value : map.data) histogram[l][std::min(static_cast<int>(value / maximum[l] * bins), bins - 1)]++;
+                }
+            }
+        }
+    for (int l = 0; l < ACNet::rangeLength(); l++)
+    {
+        std::size_t total = 0, count = 0;
+        for (auto n : histogram[l]) total += n;
+        int bin = 0;
+        while (bin < static_cast<int>(histogram[l].size()) - 1 && static_cast<double>(count += histogram[l][bin]) < static_cast<double>(total) * percentile / 100.0) bin++;
+        ranges[l] = maximum[l] * static_cast<float>(bin + 1) / bins * headroom;
+        // a layer that is always 0 still needs a valid scale
+        if (!(ranges[l] > 0.0f)) ranges[l] = 1.0f;
+    }
+}
+
+// PSNR of the int8 computation with `ranges` against the float model, per frame and the worst over them
+static void evaluate(const ACNet& model, const std::vector<FeatureMap>& frames, const float (&ranges)[ACNet::rangeLength()], const char* name, const char* set)
+{
+    int worstError = 0;
+    double worstPSNR = INFINITY;
+    for (std::size_t i = 0; i < frames.size(); i++)
+    {
+        FeatureMap ref = frames[i], q = frames[i];
+        for (int l = 0; l < ACNet::rangeLength(); l++)
+        {
+            ref = conv3x3(model, l, ref);
+            q = conv3x3Int8(model, l, q, l > 0 ? ranges[l - 1] / 255.0f : 1.0f, ranges[l] / 255.0f);
+        }
+        int maxError = 0;
+        double value = psnr(deconv2x2(model, q, ranges[ACNet::rangeLength() - 1] / 255.0f), deconv2x2(model, ref, 1.0f), maxError);
+        std::printf("%s %s frame %zu: max error %d, PSNR %lf dB against float\n", name, set, i, maxError, value);
+        worstError = std::max(worstError, maxError);
+        worstPSNR = std::min(worstPSNR, value);
+    }
+    if (!frames.empty()) std::printf("%s %s worst: max error %d, PSNR %lf dB against float\n", name, set, worstError, worstPSNR);
+}
+
+// PSNR of the built-in int8 arch of the CPU processor against the Generic arch, it uses the ranges compiled into the library
+static void evaluateProcessor(const ACNet& model, const ac::core::Image& image, const char* name)
+{
+    std::shared_ptr<ac::core::Processor> int8{}, reference{};
+    for (int i = 1; !reference; i++)
+    {
+        auto processor = ac::core::Processor::create<ac::core::Processor::CPU>(i, model);
+        if (!std::strcmp(processor->name(), "AVX2_INT8")) int8 = processor;
+        if (!std::strcmp(processor->name(), "Generic")) reference = processor;
+    }
+    if (!int8) return;
+
+    auto dst = int8->process(image, 2.0);
+    auto ref = reference->process(image, 2.0);
+    std::vector<std::uint8_t> a{}, b{};
+    for (int i = 0; i < dst.height(); i++)
+    {
+        a.insert(a.end(), dst.line(i), dst.line(i) + dst.width());
+        b.insert(b.end(), ref.line(i), ref.line(i) + ref.width());
+    }
+    int maxError = 0;
+    double value = psnr(a, b, maxError);
+    std::printf("%s %s: max error %d, PSNR %lf dB against %s\n", name, int8->name(), maxError, value, reference->name());
+}
+
+int main(int argc, char* argv[])
+{
+    std::printf("usage: [output] [frames...] [--eval frames...]\n"
+                "writes the int8 ranges of ACNet HDN0-HDN3 calibrated on the frames to output, such as core/include/AC/Core/Model/Param/ACNetInt8.p\n"
+                "a frame is an image file or synthetic:<count> for that many generated %dx%d cel frames,\n"
+                "the frames after --eval are only used to evaluate the ranges.\n", SyntheticWidth, SyntheticHeight);
+    if (argc < 3) return 0;
+
+    std::vector<ac::core::Image> images[2]{};
+    std::vector<FeatureMap> frames[2]{};
+    std::string set{};
+    int synthetics = 0;
+    for (int i = 2, eval = 0; i < argc; i++)
+    {
+        if (!std::strcmp(argv[i], "--eval"))
+        {
+            eval = 1;
+            continue;
+        }
+        if (!eval) set += set.empty() ? argv[i] : std::string{ ", " } + argv[i];
+        if (!std::strncmp(argv[i], "synthetic:", 10))
+        {
+            // the evaluation frames do not repeat the calibration ones
+            for (int n = 0, count = std::atoi(argv[i] + 10); n < count; n++)
+            {
+                auto frame = synthetic(synthetics++, SyntheticWidth, SyntheticHeight);
+                ac::core::Image image{ frame.w, frame.h, 1, ac::core::Image::UInt8 };
+                for (int y = 0; y < frame.h; y++)
+                    for (int x = 0; x < frame.w; x++) *image.pixel(x, y) = ac::core::fromFloat<std::uint8_t>(*frame.at(x, y));
+                images[eval].emplace_back(image);
+                frames[eval].emplace_back(std::move(frame));
+            }
+            continue;
+        }
+#   ifdef AC_CORE_ENABLE_IMAGE_IO
+        auto image = ac::core::imread(argv[i], ac::core::IMREAD_GRAYSCALE);
+#   else
+        ac::core::Image image{};
+#   endif
+        if (image.empty())
+        {
+            std::fprintf(stderr, "failed to load %s\n", argv[i]);
+            return 1;
+        }
+        FeatureMap frame{ image.width(), image.height(), 1 };
+        for (int y = 0; y < image.height(); y++)
+            for (int x = 0; x < image.width(); x++) *frame.at(x, y) = ac::core::toFloat(*image.pixel(x, y));
+        images[eval].emplace_back(image);
+        frames[eval].emplace_back(std::move(frame));
+    }
+    if (frames[0].empty())
+    {
+        std::fprintf(stderr, "no frame to calibrate on\n");
+        return 1;
+    }
+
+    std::FILE* file = std::fopen(argv[1], "w");
+    if (!file)
+    {
+        std::fprintf(stderr, "failed to open %s\n", argv[1]);
+        return 1;
+    }
+    std::fprintf(file, "// generated by ac_calibrate, the %gth percentile of the outputs of each conv3x3 layer of the float model times %g,\n"
+                       "// over %zu frames: %s\n", CalibratePercentile, CalibrateHeadroom, frames[0].size(), set.c_str());
+
+    const char* names[] = { "HDN0", "HDN1", "HDN2", "HDN3" };
+    const ACNet::Variant variants[] = { ACNet::Variant::HDN0, ACNet::Variant::HDN1, ACNet::Variant::HDN2, ACNet::Variant::HDN3 };
+    for (int v = 0; v < 4; v++)
+    {
+        ACNet model{ variants[v] };
+        float ranges[ACNet::rangeLength()]{};
+        calibrate(model, frames[0], CalibratePercentile, CalibrateHeadroom, ranges);
+
+        std::fprintf(file, "alignas(32) constexpr float ACNet_%s_Int8_Ranges[] = {\n", names[v]);
+        for (int l = 0; l < ACNet::rangeLength(); l++) std::fprintf(file, "%+.7ff,%s", ranges[l], (l % 8 == 7 || l == ACNet::rangeLength() - 1) ? "\n" : " ");
+        std::fprintf(file, "};\n");
+
+        for (int eval = 0; eval < 2; eval++)
+        {
+            evaluate(model, frames[eval], ranges, names[v], eval ? "evaluation" : "calibration");
+            for (auto&& image : images[eval]) evaluateProcessor(model, image, names[v]);
+        }
+    }
+    std::fclose(file);
+    return 0;
+}
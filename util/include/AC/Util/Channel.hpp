@@ -39,24 +39,27 @@ public:
     Channel<T, Queue>& operator<<(const T& obj);
     Channel<T, Queue>& operator>>(T& obj);
     std::size_t size();
+    std::size_t capacity();
+    // a smaller capacity only blocks new objects, the ones already in the channel stay.
+    void setCapacity(std::size_t n);
     bool empty();
     void close();
     bool isClose();
 private:
     bool stop = false;
-    const std::size_t capacity;
+    std::size_t limit;
     Queue queue;
     std::condition_variable consumer, producer;
     std::mutex mtx;
 };
 
 template<typename T, typename Queue>
-inline ac::util::Channel<T, Queue>::Channel(const std::size_t capacity) : capacity(capacity) {}
+inline ac::util::Channel<T, Queue>::Channel(const std::size_t capacity) : limit(capacity) {}
 template<typename T, typename Queue>
 inline ac::util::Channel<T, Queue>& ac::util::Channel<T, Queue>::operator<<(const T& obj)
 {
     std::unique_lock lock{ mtx };
-    producer.wait(lock, [&](){ return queue.size() < capacity; });
+    producer.wait(lock, [&](){ return queue.size() < limit; });
     queue.emplace(obj);
     lock.unlock();
     consumer.notify_one();
@@ -86,6 +89,21 @@ inline std::size_t ac::util::Channel<T, Queue>::size()
     return queue.size();
 }
 template<typename T, typename Queue>
+inline std::size_t ac::util::Channel<T, Queue>::capacity()
+{
+    const std::lock_guard lock{ mtx };
+    return limit;
+}
+template<typename T, typename Queue>
+inline void ac::util::Channel<T, Queue>::setCapacity(const std::size_t n)
+{
+    {
+        const std::lock_guard lock{ mtx };
+        limit = n;
+    }
+    producer.notify_all();
+}
+template<typename T, typename Queue>
 inline bool ac::util::Channel<T, Queue>::empty()
 {
     const std::lock_guard lock{ mtx };
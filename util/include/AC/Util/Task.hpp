@@ -0,0 +1,114 @@
+#ifndef AC_UTIL_TASK_HPP
+#define AC_UTIL_TASK_HPP
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ac::util
+{
+    class Task;
+}
+
+// a move-only `void()` callable, small callables are stored inline without allocation.
+class ac::util::Task
+{
+public:
+    // room for a lambda capturing up to six pointers or three shared_ptr
+    static constexpr std::size_t BufferSize = 6 * sizeof(void*);
+
+public:
+    Task() noexcept = default;
+    template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+    Task(F&& f);
+    Task(const Task&) = delete;
+    Task(Task&& other) noexcept;
+    Task& operator=(const Task&) = delete;
+    Task& operator=(Task&& other) noexcept;
+    ~Task() noexcept;
+
+    void operator()();
+    explicit operator bool() const noexcept { return vtable != nullptr; }
+
+private:
+    struct VTable
+    {
+        void (*invoke)(void*);
+        void (*move)(void* /*dst*/, void* /*src*/) noexcept;
+        void (*destroy)(void*) noexcept;
+    };
+
+    template<typename Fn>
+    struct Inline
+    {
+        static void invoke(void* const p) { (*static_cast<Fn*>(p))(); }
+        static void move(void* const dst, void* const src) noexcept { new (dst) Fn(std::move(*static_cast<Fn*>(src))); static_cast<Fn*>(src)->~Fn(); }
+        static void destroy(void* const p) noexcept { static_cast<Fn*>(p)->~Fn(); }
+        static constexpr VTable vtable{ &invoke, &move, &destroy };
+    };
+    template<typename Fn>
+    struct Heap
+    {
+        static void invoke(void* const p) { (**static_cast<Fn**>(p))(); }
+        static void move(void* const dst, void* const src) noexcept { *static_cast<Fn**>(dst) = *static_cast<Fn**>(src); }
+        static void destroy(void* const p) noexcept { delete *static_cast<Fn**>(p); }
+        static constexpr VTable vtable{ &invoke, &move, &destroy };
+    };
+
+    template<typename Fn>
+    static constexpr bool isInline = sizeof(Fn) <= BufferSize && alignof(Fn) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<Fn>;
+
+private:
+    const VTable* vtable = nullptr;
+    alignas(std::max_align_t) unsigned char buffer[BufferSize];
+};
+
+template<typename F, typename>
+inline ac::util::Task::Task(F&& f)
+{
+    using Fn = std::decay_t<F>;
+    if constexpr (isInline<Fn>)
+    {
+        new (buffer) Fn(std::forward<F>(f));
+        vtable = &Inline<Fn>::vtable;
+    }
+    else
+    {
+        *reinterpret_cast<Fn**>(buffer) = new Fn(std::forward<F>(f));
+        vtable = &Heap<Fn>::vtable;
+    }
+}
+inline ac::util::Task::Task(Task&& other) noexcept : vtable(other.vtable)
+{
+    if (vtable)
+    {
+        vtable->move(buffer, other.buffer);
+        other.vtable = nullptr;
+    }
+}
+inline ac::util::Task& ac::util::Task::operator=(Task&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (vtable) vtable->destroy(buffer);
+        vtable = other.vtable;
+        if (vtable)
+        {
+            vtable->move(buffer, other.buffer);
+            other.vtable = nullptr;
+        }
+    }
+    return *this;
+}
+inline ac::util::Task::~Task() noexcept
+{
+    if (vtable) vtable->destroy(buffer);
+}
+
+inline void ac::util::Task::operator()()
+{
+    vtable->invoke(buffer);
+}
+
+#endif
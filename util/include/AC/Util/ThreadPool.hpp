@@ -1,26 +1,35 @@
 #ifndef AC_UTIL_THREADPOOL_HPP
 #define AC_UTIL_THREADPOOL_HPP
 
+#include <atomic>
 #include <condition_variable>
 #include <cstddef>
+#include <deque>
 #include <functional>
 #include <future>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <thread>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "AC/Util/Task.hpp"
+
 namespace ac::util
 {
     class ThreadPool;
 }
 
+// every thread owns a deque, it takes its own tasks from the back and steals the oldest ones of the others from the front.
+// tasks submitted from a thread of the pool go to its own deque, others are spread over the deques in turn.
 class ac::util::ThreadPool
 {
 public:
     explicit ThreadPool(std::size_t size);
+    // `init(i)` is called on the i-th thread before it starts taking tasks.
+    ThreadPool(std::size_t size, std::function<void(std::size_t)> init);
     ThreadPool(const ThreadPool&) = delete;
     ThreadPool(ThreadPool&&) = delete;
     ThreadPool& operator=(const ThreadPool&) = delete;
@@ -29,33 +38,77 @@ public:
 
     template<typename F> void exec(F&& f);
     template<typename F, typename... Args> auto exec(F&& f, Args&&... args);
+    // submit `count` copies of `f` at once.
+    template<typename F> void execBulk(std::size_t count, const F& f);
+
+    std::size_t size() const noexcept { return threads.size(); }
 
 public:
     static unsigned int hardwareThreads() noexcept;
 
+private:
+    struct alignas(64) Queue
+    {
+        std::deque<Task> tasks;
+        std::mutex mtx;
+    };
+
+    // index of the calling thread in this pool, or size() if it does not belong to it.
+    std::size_t current() const noexcept;
+    std::size_t target() noexcept;
+    bool take(std::size_t idx, Task& task);
+    void wake(std::size_t count);
+
 private:
     bool stop = false;
+    std::unique_ptr<Queue[]> queues;
     std::vector<std::thread> threads;
-    std::queue<std::function<void()>> tasks;
+    std::atomic_size_t pending = 0;
+    std::atomic_size_t sleeping = 0;
+    std::atomic_size_t next = 0;
     std::condition_variable cnd;
     std::mutex mtx;
 };
 
-inline ac::util::ThreadPool::ThreadPool(const std::size_t size)
+namespace ac::util::detail
+{
+    struct ThreadPoolWorker
+    {
+        const ThreadPool* pool = nullptr;
+        std::size_t idx = 0;
+    };
+
+    inline ThreadPoolWorker& threadPoolWorker() noexcept
+    {
+        static thread_local ThreadPoolWorker worker{};
+        return worker;
+    }
+}
+
+inline ac::util::ThreadPool::ThreadPool(const std::size_t size) : ThreadPool(size, nullptr) {}
+
+inline ac::util::ThreadPool::ThreadPool(const std::size_t size, std::function<void(std::size_t)> init) : queues(std::make_unique<Queue[]>(size))
 {
     threads.reserve(size);
 
     for (std::size_t i = 0; i < size; i++)
-        threads.emplace_back([this]() {
+        threads.emplace_back([this, i, init]() {
+            detail::threadPoolWorker() = { this, i };
+            if (init) init(i);
+            Task task{};
             for (;;)
             {
+                if (take(i, task))
+                {
+                    task();
+                    task = Task{};
+                    continue;
+                }
                 std::unique_lock lock{ mtx };
-                cnd.wait(lock, [this] { return stop || !tasks.empty(); });
-                if (stop && tasks.empty()) return;
-                auto task = std::move(tasks.front());
-                tasks.pop();
-                lock.unlock();
-                task();
+                if (stop && pending == 0) return;
+                sleeping++;
+                cnd.wait(lock, [this] { return stop || pending > 0; });
+                sleeping--;
             }
         });
 }
@@ -73,24 +126,44 @@ inline ac::util::ThreadPool::~ThreadPool()
 template<typename F>
 inline void ac::util::ThreadPool::exec(F&& f)
 {
+    auto& queue = queues[target()];
+    pending++;
     {
-        const std::lock_guard lock{ mtx };
-        tasks.emplace(std::forward<F>(f));
+        const std::lock_guard lock{ queue.mtx };
+        queue.tasks.emplace_back(std::forward<F>(f));
     }
-    cnd.notify_one();
+    wake(1);
 }
 
 template<typename F, typename ...Args>
 inline auto ac::util::ThreadPool::exec(F&& f, Args && ...args)
 {
-    auto task = std::make_shared<std::packaged_task<decltype(std::declval<F>()(std::declval<Args>()...))()>>(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
-    auto ret = task->get_future();
+    std::packaged_task<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>()> task{
+        [f = std::forward<F>(f), args = std::make_tuple(std::forward<Args>(args)...)]() mutable { return std::apply(std::move(f), std::move(args)); }
+    };
+    auto ret = task.get_future();
+    exec(std::move(task));
+    return ret;
+}
+
+template<typename F>
+inline void ac::util::ThreadPool::execBulk(const std::size_t count, const F& f)
+{
+    if (!count) return;
+    const auto self = current();
+    const auto queueCount = size();
+    // spread the copies over the deques, one lock per deque
+    const auto first = self < queueCount ? self : next.fetch_add(1, std::memory_order_relaxed) % queueCount;
+    const auto spread = self < queueCount ? 1 : (count < queueCount ? count : queueCount);
+    pending += count;
+    for (std::size_t q = 0; q < spread; q++)
     {
-        const std::lock_guard lock{ mtx };
-        tasks.emplace([=]() { (*task)(); });
+        auto& queue = queues[(first + q) % queueCount];
+        const auto n = count / spread + (q < count % spread ? 1 : 0);
+        const std::lock_guard lock{ queue.mtx };
+        for (std::size_t i = 0; i < n; i++) queue.tasks.emplace_back(f);
     }
-    cnd.notify_one();
-    return ret;
+    wake(count);
 }
 
 inline unsigned int ac::util::ThreadPool::hardwareThreads() noexcept
@@ -99,4 +172,54 @@ inline unsigned int ac::util::ThreadPool::hardwareThreads() noexcept
     return num ? num : 1;
 }
 
+inline std::size_t ac::util::ThreadPool::current() const noexcept
+{
+    const auto& worker = detail::threadPoolWorker();
+    return worker.pool == this ? worker.idx : size();
+}
+inline std::size_t ac::util::ThreadPool::target() noexcept
+{
+    const auto self = current();
+    return self < size() ? self : next.fetch_add(1, std::memory_order_relaxed) % size();
+}
+inline bool ac::util::ThreadPool::take(const std::size_t idx, Task& task)
+{
+    if (pending == 0) return false;
+    {
+        auto& queue = queues[idx];
+        const std::lock_guard lock{ queue.mtx };
+        if (!queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            pending--;
+            return true;
+        }
+    }
+    for (std::size_t i = 1; i < size(); i++)
+    {
+        auto& queue = queues[(idx + i) % size()];
+        const std::unique_lock lock{ queue.mtx, std::try_to_lock };
+        if (lock && !queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            pending--;
+            return true;
+        }
+    }
+    return false;
+}
+// `pending` is increased before `sleeping` is read here, and a thread increases `sleeping` under the lock before it checks `pending`,
+// so either the thread sees the new tasks or it is counted here and gets notified.
+inline void ac::util::ThreadPool::wake(const std::size_t count)
+{
+    if (sleeping == 0) return;
+    {
+        const std::lock_guard lock{ mtx };
+    }
+    if (count > 1) cnd.notify_all();
+    else cnd.notify_one();
+}
+
 #endif
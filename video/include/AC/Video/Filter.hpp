@@ -1,6 +1,8 @@
 #ifndef AC_VIDEO_FILTER_HPP
 #define AC_VIDEO_FILTER_HPP
 
+#include <cstddef>
+
 #include "AC/Video/Pipeline.hpp"
 
 namespace ac::video
@@ -12,7 +14,50 @@ namespace ac::video
         FILTER_SERIAL   = 2
     };
 
+    // with FILTER_PARALLEL, `callback` is called concurrently from one thread per compute thread of the core runtime,
+    // so a processor used in it should run its kernels serially, see ac::core::Processor::ExecutionSerial.
     void filter(Pipeline& pipeline, bool (*callback)(Frame& /*src*/, Frame& /*dst*/, void* /*userdata*/), void* userdata, int flag);
 }
 
+namespace ac::video::detail
+{
+    // Resize the set of active workers and the channel capacities while the video is running. The decoder samples the
+    // occupancy of both channels after each frame it sends, and every window of frames the controller decides which stage
+    // is the bottleneck: a full encode channel means encoding is, so fewer workers are needed; otherwise a full decode
+    // channel means processing is, so one more worker is woken up; and an almost empty decode channel means decoding is,
+    // so one worker is parked to leave the cpu to the decoder and encoder. used by ac::video::filter, it is here as a hook for tests.
+    class FilterController
+    {
+    public:
+        explicit FilterController(const std::size_t maxWorkers) noexcept : maxWorkers(maxWorkers), workers(maxWorkers) {}
+
+        // returns true if the number of active workers has changed
+        bool update(const std::size_t decodeSize, const std::size_t encodeSize) noexcept
+        {
+            decodeFill += decodeSize;
+            encodeFill += encodeSize;
+            if (++samples < window()) return false;
+
+            const std::size_t full = samples * capacity();
+            const auto prev = workers;
+            if (encodeFill * 4 >= full * 3) workers = workers > 1 ? workers - 1 : 1;
+            else if (decodeFill * 4 >= full * 3) workers = workers < maxWorkers ? workers + 1 : maxWorkers;
+            else if (decodeFill * 4 <= full) workers = workers > 1 ? workers - 1 : 1;
+            samples = decodeFill = encodeFill = 0;
+            return workers != prev;
+        }
+        std::size_t active() const noexcept { return workers; }
+        // two frames per worker, one being processed and one waiting
+        std::size_t capacity() const noexcept { return workers * 2; }
+
+    private:
+        std::size_t window() const noexcept { return capacity() < 8 ? 8 : capacity() * 2; }
+
+    private:
+        const std::size_t maxWorkers;
+        std::size_t workers;
+        std::size_t samples = 0, decodeFill = 0, encodeFill = 0;
+    };
+}
+
 #endif
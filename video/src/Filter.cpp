@@ -1,8 +1,11 @@
 #include <atomic>
+#include <condition_variable>
 #include <cstddef>
 #include <functional>
+#include <mutex>
 #include <queue>
 
+#include "AC/Core/Runtime.hpp"
 #include "AC/Util/Channel.hpp"
 #include "AC/Util/ThreadPool.hpp"
 #include "AC/Video/Filter.hpp"
@@ -30,13 +33,22 @@ namespace ac::video::detail
         pipeline.release(dst);
     }
 
+    // up to one worker per compute thread of the core runtime. the stages block on the channels until the whole video is done,
+    // so they get their own threads instead of occupying the compute threads the callback schedules its work on.
     inline static void filterParallel(Pipeline& pipeline, bool (* const callback)(Frame& /*src*/, Frame& /*dst*/, void* /*userdata*/), void* const userdata)
     {
+        const auto maxWorkers = static_cast<std::size_t>(core::runtime::threads());
+        FilterController controller{ maxWorkers };
         std::atomic_bool success = true;
-        std::atomic_size_t threads = util::ThreadPool::hardwareThreads();
-        util::Channel<Frame> decodeChan{ threads };
-        util::AscendingChannel<Frame> encodeChan{ threads };
-        util::ThreadPool pool{ threads + 1 };
+        std::atomic_size_t threads = maxWorkers;
+        util::Channel<Frame> decodeChan{ controller.capacity() };
+        util::AscendingChannel<Frame> encodeChan{ controller.capacity() };
+        util::ThreadPool pool{ maxWorkers + 1 };
+        // workers with an index not less than `active` wait here until they are needed again or the decoding ends
+        std::size_t active = controller.active();
+        bool decoded = false;
+        std::condition_variable parking{};
+        std::mutex mtx{};
 
         pool.exec([&](){
             int idx = 1;
@@ -69,9 +81,13 @@ namespace ac::video::detail
             while(!encodeChan.empty()) process();
         });
 
-        for (std::size_t i = 0; i < threads; i++)
+        for (std::size_t i = 0; i < maxWorkers; i++)
         {
-            pool.exec([&](){
+            pool.exec([&, i](){
+                auto park = [&](){
+                    std::unique_lock lock{ mtx };
+                    parking.wait(lock, [&]() { return i < active || decoded; });
+                };
                 auto process = [&](){
                     bool ret = true;
                     Frame src{};
@@ -89,7 +105,7 @@ namespace ac::video::detail
                     else pipeline.release(src);
                     success = success && ret;
                 };
-                while (!decodeChan.isClose()) process();
+                while (!decodeChan.isClose()) { park(); process(); }
                 while (!decodeChan.empty()) process();
                 // last one close the door
                 if(--threads == 0) encodeChan.close();
@@ -97,8 +113,26 @@ namespace ac::video::detail
         }
 
         Frame src{};
-        while (success && pipeline >> src) decodeChan << src;
+        while (success && pipeline >> src)
+        {
+            decodeChan << src;
+            if (controller.update(decodeChan.size(), encodeChan.size()))
+            {
+                decodeChan.setCapacity(controller.capacity());
+                encodeChan.setCapacity(controller.capacity());
+                {
+                    const std::lock_guard lock{ mtx };
+                    active = controller.active();
+                }
+                parking.notify_all();
+            }
+        }
         decodeChan.close();
+        {
+            const std::lock_guard lock{ mtx };
+            decoded = true;
+        }
+        parking.notify_all();
     }
 }
 
@@ -106,7 +140,7 @@ void ac::video::filter(Pipeline& pipeline, bool (* const callback)(Frame& /*src*
 {
     if (!callback) return;
 
-    if (flag == FILTER_PARALLEL || (flag == FILTER_AUTO && util::ThreadPool::hardwareThreads() > 1))
+    if (flag == FILTER_PARALLEL || (flag == FILTER_AUTO && core::runtime::threads() > 1))
         detail::filterParallel(pipeline, callback, userdata);
     else
         detail::filterSerial(pipeline, callback, userdata);